@@ -5,28 +5,60 @@
 #include "DataFormats/PatCandidates/interface/PackedGenParticle.h"
 
 //! Expose packed values which have no public accessor but are protected members
-class PackedPatCandidateExposer : public pat::PackedCandidate {
+/*!
+ * The values are read from the original object through pointers to the protected members,
+ * which a derived class is allowed to form. Nothing is copied, so the lazily unpacked p4,
+ * vertex and track caches of the candidate are never touched.
+ */
+class PackedPatCandidateExposer {
  public:
-  PackedPatCandidateExposer(pat::PackedCandidate const& cand) : pat::PackedCandidate(cand) {}
-  uint16_t packedPt() const { return packedPt_; }
-  uint16_t packedEta() const { return packedEta_; }
-  uint16_t packedPhi() const { return packedPhi_; }
-  uint16_t packedM() const { return packedM_; }
-  int16_t packedPuppiweight() const { return packedPuppiweight_; }
-  int16_t packedPuppiweightNoLepDiff() const { return packedPuppiweightNoLepDiff_; }
-  uint16_t packedDxy() const { return packedDxy_; }
-  uint16_t packedDz() const { return packedDz_; }
-  uint16_t packedDPhi() const { return packedDPhi_; }
+  PackedPatCandidateExposer(pat::PackedCandidate const& cand) : cand_(cand) {}
+  uint16_t packedPt() const { return Access::packedPt(cand_); }
+  uint16_t packedEta() const { return Access::packedEta(cand_); }
+  uint16_t packedPhi() const { return Access::packedPhi(cand_); }
+  uint16_t packedM() const { return Access::packedM(cand_); }
+  int16_t packedPuppiweight() const { return Access::packedPuppiweight(cand_); }
+  int16_t packedPuppiweightNoLepDiff() const { return Access::packedPuppiweightNoLepDiff(cand_); }
+  uint16_t packedDxy() const { return Access::packedDxy(cand_); }
+  uint16_t packedDz() const { return Access::packedDz(cand_); }
+  uint16_t packedDPhi() const { return Access::packedDPhi(cand_); }
+
+ private:
+  //! Never instantiated; only forms the member pointers
+  struct Access : pat::PackedCandidate {
+    static uint16_t packedPt(pat::PackedCandidate const& c) { return c.*(&Access::packedPt_); }
+    static uint16_t packedEta(pat::PackedCandidate const& c) { return c.*(&Access::packedEta_); }
+    static uint16_t packedPhi(pat::PackedCandidate const& c) { return c.*(&Access::packedPhi_); }
+    static uint16_t packedM(pat::PackedCandidate const& c) { return c.*(&Access::packedM_); }
+    static int16_t packedPuppiweight(pat::PackedCandidate const& c) { return c.*(&Access::packedPuppiweight_); }
+    static int16_t packedPuppiweightNoLepDiff(pat::PackedCandidate const& c) { return c.*(&Access::packedPuppiweightNoLepDiff_); }
+    static uint16_t packedDxy(pat::PackedCandidate const& c) { return c.*(&Access::packedDxy_); }
+    static uint16_t packedDz(pat::PackedCandidate const& c) { return c.*(&Access::packedDz_); }
+    static uint16_t packedDPhi(pat::PackedCandidate const& c) { return c.*(&Access::packedDPhi_); }
+  };
+
+  pat::PackedCandidate const& cand_;
 };
 
-//! Expose packed values which have no public accessor but are protected members
-class PackedGenParticleExposer : public pat::PackedGenParticle {
+//! Expose packed values which have no public accessor but are protected members (see PackedPatCandidateExposer)
+class PackedGenParticleExposer {
  public:
-  PackedGenParticleExposer(pat::PackedGenParticle const& part) : pat::PackedGenParticle(part) {}
-  uint16_t packedPt() const { return packedPt_; }
-  uint16_t packedY() const { return packedY_; }
-  uint16_t packedPhi() const { return packedPhi_; }
-  uint16_t packedM() const { return packedM_; }
+  PackedGenParticleExposer(pat::PackedGenParticle const& part) : part_(part) {}
+  uint16_t packedPt() const { return Access::packedPt(part_); }
+  uint16_t packedY() const { return Access::packedY(part_); }
+  uint16_t packedPhi() const { return Access::packedPhi(part_); }
+  uint16_t packedM() const { return Access::packedM(part_); }
+
+ private:
+  //! Never instantiated; only forms the member pointers
+  struct Access : pat::PackedGenParticle {
+    static uint16_t packedPt(pat::PackedGenParticle const& p) { return p.*(&Access::packedPt_); }
+    static uint16_t packedY(pat::PackedGenParticle const& p) { return p.*(&Access::packedY_); }
+    static uint16_t packedPhi(pat::PackedGenParticle const& p) { return p.*(&Access::packedPhi_); }
+    static uint16_t packedM(pat::PackedGenParticle const& p) { return p.*(&Access::packedM_); }
+  };
+
+  pat::PackedGenParticle const& part_;
 };
 
 #endif
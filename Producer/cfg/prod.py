@@ -8,6 +8,7 @@ options.register('lumilist', default = '', mult = VarParsing.multiplicity.single
 options.register('isData', default = False, mult = VarParsing.multiplicity.singleton, mytype = VarParsing.varType.bool, info = 'True if running on Data, False if running on MC')
 options.register('useTrigger', default = True, mult = VarParsing.multiplicity.singleton, mytype = VarParsing.varType.bool, info = 'Fill trigger information')
 options.register('printLevel', default = 0, mult = VarParsing.multiplicity.singleton, mytype = VarParsing.varType.int, info = 'Debug level of the ntuplizer')
+options.register('nThreads', default = 1, mult = VarParsing.multiplicity.singleton, mytype = VarParsing.varType.int, info = 'Number of threads (and streams)')
 options.register('skipEvents', default = 0, mult = VarParsing.multiplicity.singleton, mytype = VarParsing.varType.int, info = 'Skip first events')
 options._tags.pop('numEvent%d')
 options._tagOrder.remove('numEvent%d')
@@ -52,6 +53,13 @@ process.maxEvents = cms.untracked.PSet(
     input = cms.untracked.int32(options.maxEvents)
 )
 
+### MULTITHREADING
+# each stream writes its own segment; PandaProducer merges them into outputFile at the end of the job
+process.options = cms.untracked.PSet(
+    numberOfThreads = cms.untracked.uint32(options.nThreads),
+    numberOfStreams = cms.untracked.uint32(0)
+)
+
 ### LUMI MASK
 if options.lumilist != '':
     import FWCore.PythonUtilities.LumiList as LumiList
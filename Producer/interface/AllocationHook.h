@@ -0,0 +1,28 @@
+#ifndef PandaProd_Producer_AllocationHook_h
+#define PandaProd_Producer_AllocationHook_h
+
+//! Interface of the allocation hook library
+/*!
+ * libPandaProdAllocationHook.so interposes malloc, free, and the C++ allocation operators when
+ * loaded with LD_PRELOAD, e.g.
+ *  LD_PRELOAD=$CMSSW_BASE/lib/$SCRAM_ARCH/libPandaProdAllocationHook.so cmsRun prod.py
+ * Allocations are counted into the counters set for the calling thread and forwarded to glibc.
+ * PandaProducer looks up pandaAllocSetScope at run time, so the plugin does not link to the hook.
+ */
+
+extern "C" {
+
+  struct PandaAllocCounts {
+    unsigned long long nAlloc;
+    unsigned long long nFree;
+    unsigned long long bytes; //! requested bytes
+  };
+
+  //! Set the counters of the calling thread (0 -> no counting). Returns the previous counters.
+  PandaAllocCounts* pandaAllocSetScope(PandaAllocCounts*);
+
+}
+
+typedef PandaAllocCounts* (*PandaAllocSetScopeFunc)(PandaAllocCounts*);
+
+#endif
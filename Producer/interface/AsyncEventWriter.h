@@ -0,0 +1,65 @@
+#ifndef PandaProd_Producer_AsyncEventWriter_h
+#define PandaProd_Producer_AsyncEventWriter_h
+
+#include "PandaTree/Objects/interface/Event.h"
+
+#include "TTree.h"
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+
+//! Writes the events tree from a dedicated thread
+/*!
+ * The writer owns a pool of panda::Event buffers and one event with which the tree branches are booked. The
+ * producer fills a buffer obtained from acquire() and hands it back with submit(). The writer thread points
+ * the tree branches to each submitted buffer (setAddress), calls TTree::Fill, and releases the tree from the
+ * buffer again, in submission order. Nothing is copied, and serialization and compression of event N overlap
+ * with the filling of event N+1. acquire() blocks while all buffers are in flight.
+ * A buffer is never bound to the tree while the producer fills it, so a collection that grows (and
+ * reallocates) in the producer thread does not touch the tree.
+ *
+ * The tree and its file must not be touched by other threads while writes are pending; call drain() before
+ * filling any other tree of the same file, adding branches to the events tree, or closing the file.
+ */
+class AsyncEventWriter {
+ public:
+  AsyncEventWriter(TTree&, panda::utils::BranchList const&, unsigned nBuffers);
+  ~AsyncEventWriter();
+
+  //! Event with which the tree branches are booked. Only safe to access after drain(). Once events have been
+  //! written, the branches point to the last written buffer; a branch added later points here until the next write.
+  panda::Event& treeEvent() { return treeEvent_; }
+
+  //! Next buffer to fill. Blocks until a buffer is available.
+  panda::Event& acquire();
+  //! Queue the buffer returned by the last acquire() for writing.
+  void submit();
+  //! Block until all submitted events are written. Rethrows an exception raised in the writer thread.
+  void drain();
+
+ private:
+  void run_();
+  void rethrow_();
+
+  TTree& tree_;
+  panda::Event treeEvent_{};
+  std::vector<std::unique_ptr<panda::Event>> buffers_{};
+
+  std::deque<panda::Event*> free_{};
+  std::deque<panda::Event*> queue_{};
+  panda::Event* current_{0};
+  bool writing_{false};
+  bool stop_{false};
+  std::exception_ptr exception_{};
+
+  std::mutex mutex_{};
+  std::condition_variable cond_{};
+  std::thread thread_;
+};
+
+#endif
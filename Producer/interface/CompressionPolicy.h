@@ -0,0 +1,60 @@
+#ifndef PandaProd_Producer_CompressionPolicy_h
+#define PandaProd_Producer_CompressionPolicy_h
+
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+
+#include "TFile.h"
+#include "TTree.h"
+
+#include <string>
+#include <vector>
+#include <ostream>
+
+//! Output compression and buffering settings
+/*!
+ * Configured from the "compression" PSet of PandaProducer:
+ *  algorithm, level: file-wide default ("zlib", "lzma", "lz4"; empty -> ROOT default)
+ *  basketSize: initial basket size of all events tree branches (0 -> ROOT default)
+ *  autoFlush: argument to TTree::SetAutoFlush for the events tree (0 -> ROOT default)
+ *  implicitMT: compress baskets of the events tree in parallel when ROOT implicit MT is enabled (unset -> ROOT default)
+ *  report: print bytes and compression ratio per branch group of the events tree at the end of the job
+ *  groups: PSet of PSets (algorithm, level, branches), overriding the default for the listed branches.
+ *   Entries of branches are either full branch names ("chsAK4Jets.pt") or object names ("chsAK4Jets").
+ *   A full-name match takes precedence over an object-name match.
+ */
+class CompressionPolicy {
+ public:
+  CompressionPolicy(edm::ParameterSet const&);
+
+  //! Default settings of the file (-1 if unset). Applies to all trees and branches created afterwards.
+  int fileSettings() const { return fileSettings_; }
+  bool doReport() const { return report_; }
+
+  //! Set the default compression of the file
+  void configure(TFile&) const;
+  //! Apply the buffering, implicit-MT, and per-branch settings to the events tree
+  void configure(TTree&) const;
+
+  //! Print uncompressed and compressed bytes per object (top-level branch name) of the tree
+  void report(TTree&, std::ostream&) const;
+
+ private:
+  struct BranchGroup {
+    std::string name;
+    int settings;
+    std::vector<std::string> branches;
+  };
+
+  static int parseSettings_(edm::ParameterSet const&, std::string const& context);
+  //! Group index for the branch, -1 if none
+  int findGroup_(std::string const& branchName) const;
+
+  int fileSettings_{-1};
+  int basketSize_{0};
+  long long autoFlush_{0};
+  int implicitMT_{-1}; //! -1 -> ROOT default
+  bool report_{false};
+  std::vector<BranchGroup> groups_{};
+};
+
+#endif
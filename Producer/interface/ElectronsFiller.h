@@ -13,6 +13,7 @@
 #include "DataFormats/EgammaReco/interface/SuperClusterFwd.h"
 #include "DataFormats/Candidate/interface/CandidateFwd.h"
 #include "DataFormats/BeamSpot/interface/BeamSpot.h"
+#include "DataFormats/PatCandidates/interface/TriggerObjectStandAlone.h"
 
 #include "RecoEgamma/EgammaTools/interface/EffectiveAreas.h"
 
@@ -28,8 +29,12 @@ class ElectronsFiller : public FillerBase {
   void addOutput(TFile&) override;
   void fill(panda::Event&, edm::Event const&, edm::EventSetup const&) override;
   void setRefs(ObjectMapStore const&) override;
+  void resolveObjectMaps(ObjectMapStore const&) override;
+  void dependencies(VString&) const override;
 
  protected:
+  void bookObjectMaps_() override;
+
   typedef edm::View<reco::Vertex> VertexView;
   typedef edm::View<reco::Photon> PhotonView;
   typedef edm::View<reco::GsfElectron> GsfElectronView;
@@ -74,6 +79,18 @@ class ElectronsFiller : public FillerBase {
   EffectiveAreas phPhIsoEA_;
 
   std::set<std::string> triggerObjectNames_[panda::Electron::nTriggerObjects];
+
+  ObjectMap<reco::GsfElectron, panda::Electron>* eleEleMap_{0};
+  ObjectMap<reco::SuperCluster, panda::Electron>* scEleMap_{0};
+  ObjectMap<reco::Candidate, panda::Electron>* pfEleMap_{0};
+  ObjectMap<reco::Vertex, panda::Electron>* vtxEleMap_{0};
+  ObjectMap<reco::Candidate, panda::Electron>* genEleMap_{0};
+
+  ObjectMap<reco::SuperCluster, panda::SuperCluster> const* scMap_{0};
+  ObjectMap<reco::Candidate, panda::PFCand> const* pfMap_{0};
+  ObjectMap<reco::Vertex, panda::RecoVertex> const* vtxMap_{0};
+  ObjectMap<reco::Candidate, panda::GenParticle> const* genMap_{0};
+  ObjectMap<pat::TriggerObjectStandAlone, VString> const* hltNameMap_{0};
 };
 
 #endif
@@ -7,6 +7,7 @@
 #include "DataFormats/BTauReco/interface/BoostedDoubleSVTagInfo.h"
 #include "PandaProd/Utilities/interface/HEPTopTaggerWrapperV2.h"
 #include "PandaProd/Utilities/interface/EnergyCorrelations.h"
+#include "PandaProd/Utilities/interface/HierarchicalNjettiness.h"
 #include "PandaProd/Utilities/interface/BoostedBtaggingMVACalculator.h"
 
 // fastjet
@@ -26,6 +27,8 @@ class FatJetsFiller : public JetsFiller {
   ~FatJetsFiller();
 
   void branchNames(panda::utils::BranchList& eventBranches, panda::utils::BranchList&) const override;
+  //! Total number of constituents of the fat jets
+  int lastFillSize() const override { return nConstituents_; }
 
  protected:
   void fillDetails_(panda::Event&, edm::Event const&, edm::EventSetup const&) override;
@@ -41,11 +44,15 @@ class FatJetsFiller : public JetsFiller {
 
   fastjet::GhostedAreaSpec activeArea_;
   fastjet::AreaDefinition areaDef_;
+  //! Recluster with explicit ghosts. None of the stored observables uses the areas; the ghosts only cost time.
+  bool useAreas_{true};
+  //! Evaluate the HTT triplets concurrently. Requires a FastJet build with thread safety (not the CMSSW one).
+  bool parallelTopTagger_{false};
   fastjet::JetDefinition* jetDefCA_{0};
   fastjet::contrib::SoftDrop* softdrop_{0};
-  fastjet::contrib::Njettiness* tau_{0};
+  HierarchicalNjettiness* tau_{0};
   fastjet::HEPTopTaggerV2* htt_{0};
-  ECFNManager* ecfnManager_{0};
+  ECFCalculator* ecfCalculator_{0};
   panda::BoostedBtaggingMVACalculator jetBoostedBtaggingMVACalc_{};
 
   enum SubstructureComputeMode {
@@ -59,6 +66,8 @@ class FatJetsFiller : public JetsFiller {
   OutSubjetSelector outSubjetSelector_{};
 
   SubstructureComputeMode computeSubstructure_{kNever};
+
+  int nConstituents_{0};
 };
 
 #endif
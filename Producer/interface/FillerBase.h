@@ -11,6 +11,7 @@
 #include "PandaTree/Objects/interface/Event.h"
 #include "PandaTree/Objects/interface/Run.h"
 #include "ObjectMap.h"
+#include "PandaProd/Utilities/interface/KeySort.h"
 
 #include "TFile.h"
 
@@ -37,6 +38,8 @@ class FillerBase {
   virtual void fill(panda::Event&, edm::Event const&, edm::EventSetup const&) = 0;
   //! Set references
   virtual void setRefs(ObjectMapStore const&) {}
+  //! Obtain handles to the ObjectMaps of other fillers used in setRefs. Called once after all fillers booked their maps.
+  virtual void resolveObjectMaps(ObjectMapStore const&) {}
   //! Fill "all events" information (guaranteed write regardless of skims)
   virtual void fillAll(edm::Event const&, edm::EventSetup const&) {}
   //! Fill the run tree
@@ -46,9 +49,24 @@ class FillerBase {
   //! Called (indirectly) by CMSSW framework whenever a new product is registered to Event
   virtual void notifyNewProduct(edm::BranchDescription const&, edm::ConsumesCollector&) {}
 
+  //! Receives the panda::Event bound to the events tree. Differs from the event passed to fill() when the output is written asynchronously.
+  virtual void setTreeEvent(panda::Event&) {}
+  //! Return true if the next fillAll() may add branches to the events tree. Pending asynchronous writes are completed first.
+  virtual bool modifiesEventTree() const { return false; }
+
+  //! Names of the fillers whose ObjectMaps are read in setRefs (used by FillerScheduler)
+  virtual void dependencies(VString&) const {}
+  //! Event branches not listed in branchNames that are modified in setRefs (used by FillerScheduler)
+  virtual void refBranches(VString&) const {}
+  //! Non-thread-safe resources used in fill(). Fillers sharing a resource are never run concurrently.
+  virtual void sharedResources(VString&) const {}
+  //! Number of input objects processed in the last fill(), -1 if not counted (recorded for slow events)
+  virtual int lastFillSize() const { return -1; }
+
   std::string const& getName() const { return fillerName_; }
   bool enabled() const { return enabled_; }
-  void setObjectMap(FillerObjectMap& map) { objectMap_ = &map; }
+  //! Set the ObjectMap store of this filler and book the maps it fills
+  void setObjectMap(FillerObjectMap& map) { objectMap_ = &map; bookObjectMaps_(); }
 
  private:
   std::string const fillerName_;
@@ -126,6 +144,12 @@ class FillerBase {
   template<class Product, edm::BranchType B>
   void getTokenImpl_(NamedToken<Product>&, edm::ParameterSet const&, edm::ConsumesCollector&, std::string const& fname, std::string const& pname, bool mandatory = true);
 
+  //! Create the ObjectMaps filled by this filler and keep handles to them
+  virtual void bookObjectMaps_() {}
+  //! Handle to an ObjectMap of another filler. Throws a Configuration exception if the map was not booked.
+  template<class EDM, class PANDA>
+  ObjectMap<EDM, PANDA> const* resolveObjectMap_(ObjectMapStore const&, std::string const& fillerName, std::string const& label = "") const;
+
   //! get a product from the Event or Run.
   template<class Principal, class Product>
   Product const& getProduct_(Principal const&, NamedToken<Product> const&, edm::Handle<Product>* = 0);
@@ -192,6 +216,21 @@ FillerBase::getTokenImpl_(NamedToken<Product>& _token, edm::ParameterSet const&
     _token.second = _coll.consumes<Product, B>(edm::InputTag(paramValue));
 }
 
+template<class EDM, class PANDA>
+ObjectMap<EDM, PANDA> const*
+FillerBase::resolveObjectMap_(ObjectMapStore const& _objectMaps, std::string const& _fillerName, std::string const& _label/* = ""*/) const
+{
+  auto sItr(_objectMaps.find(_fillerName));
+  ObjectMap<EDM, PANDA> const* map(sItr == _objectMaps.end() ? 0 : sItr->second.findMap<EDM, PANDA>(_label));
+
+  if (!map)
+    throw edm::Exception(edm::errors::Configuration, getName() + "::resolveObjectMaps()")
+      << "Filler " << _fillerName << " is not enabled or does not provide the ObjectMap "
+      << typeid(EDM).name() << " -> " << typeid(PANDA).name() << " with label \"" << _label << "\"";
+
+  return map;
+}
+
 template<class Principal, class Product>
 Product const&
 FillerBase::getProduct_(Principal const& _prn, NamedToken<Product> const& _token, edm::Handle<Product>* _handle/* = 0*/)
@@ -227,6 +266,59 @@ FillerBase::getProductSafe_(Principal const& _prn, NamedToken<Product> const& _t
 
 void fillP4(panda::Particle&, reco::Candidate const&);
 
+//! Reorder a panda collection so that element i becomes the original element order[i]
+/*!
+ * Elements are moved through their copy assignment, so the collection must be accessed through its
+ * own type (not through the collection of a base class of its elements).
+ */
+template<class Collection>
+void
+applyPermutation(Collection& _collection, std::vector<unsigned> const& _order)
+{
+  typedef typename std::remove_reference<decltype(_collection[0])>::type Element;
+
+  std::vector<bool> done(_order.size(), false);
+  for (unsigned start(0); start != _order.size(); ++start) {
+    if (done[start] || _order[start] == start)
+      continue;
+
+    // walk the cycle, shifting each element by one step
+    Element first(_collection[start]);
+    unsigned i(start);
+    while (true) {
+      done[i] = true;
+      unsigned source(_order[i]);
+      if (source == start) {
+        _collection[i] = first;
+        break;
+      }
+      _collection[i] = _collection[source];
+      i = source;
+    }
+  }
+}
+
+//! Sort a panda collection by descending pt
+/*!
+ * Same order as collection.sort(panda::Particle::PtGreater), with equal pts kept in their original order,
+ * but pt() is evaluated only once per element. Returns the original indices of the sorted elements.
+ */
+template<class Collection>
+std::vector<unsigned>
+sortByPt(Collection& _collection)
+{
+  std::vector<uint64_t> keys(_collection.size());
+  for (unsigned i(0); i != keys.size(); ++i)
+    keys[i] = ~panda::doubleKey(_collection[i].pt());
+
+  std::vector<unsigned> order;
+  panda::keySort(keys, order);
+
+  applyPermutation(_collection, order);
+
+  return order;
+}
+
 //--------------------------------------------------------------------------------------------------
 // FillerFactory: a trick to register individual fillers as "plugin modules"
 //--------------------------------------------------------------------------------------------------
@@ -0,0 +1,55 @@
+#ifndef PandaProd_Producer_FillerScheduler_h
+#define PandaProd_Producer_FillerScheduler_h
+
+#include "FillerBase.h"
+
+#include "tbb/flow_graph.h"
+
+#include <functional>
+#include <memory>
+#include <exception>
+#include <mutex>
+#include <atomic>
+#include <ostream>
+
+//! Runs fill() and setRefs() of the fillers of one event as a TBB flow graph
+/*!
+ * Every enabled filler X contributes two nodes, fill(X) and setRefs(X). The reference ordering is the
+ * sequential one (fill() of all fillers in configuration order, then setRefs()), and two nodes keep their
+ * reference order whenever they access a common resource with at least one write:
+ *  - fill(X) writes the event branches of X (branchNames) and the ObjectMap of X
+ *  - setRefs(X) reads the ObjectMap of X and the ObjectMaps and event branches of X->dependencies(),
+ *    and writes the event branches of X and X->refBranches()
+ *  - fill(X) writes every entry of X->sharedResources()
+ * All other pairs of nodes are independent and may run concurrently. A filler that does not declare any event
+ * branch is assumed to write everything.
+ */
+class FillerScheduler {
+ public:
+  //! The argument is the index of the filler in the vector passed to the constructor
+  typedef std::function<void(unsigned)> Step;
+
+  FillerScheduler(std::vector<FillerBase*> const&, Step const& fill, Step const& setRefs);
+  ~FillerScheduler() {}
+
+  //! Process one event. The first exception thrown by any step is rethrown after all running steps return.
+  void run();
+
+  //! Print the edges of the graph
+  void print(std::ostream&) const;
+
+ private:
+  typedef tbb::flow::continue_node<tbb::flow::continue_msg> Node;
+
+  tbb::flow::graph graph_{};
+  tbb::flow::broadcast_node<tbb::flow::continue_msg> start_;
+  std::vector<std::unique_ptr<Node>> nodes_{};
+  std::vector<std::string> nodeNames_{};
+  std::vector<std::pair<unsigned, unsigned>> edges_{};
+
+  std::mutex exceptionMutex_{};
+  std::exception_ptr exception_{};
+  std::atomic<bool> failed_{false};
+};
+
+#endif
@@ -15,6 +15,8 @@ class GenJetsFiller : public FillerBase {
   void fill(panda::Event&, edm::Event const&, edm::EventSetup const&) override;
 
  protected:
+  void bookObjectMaps_() override;
+
   typedef edm::View<reco::GenJet> GenJetView;
 
   NamedToken<GenJetView> genJetsToken_;
@@ -25,6 +27,8 @@ class GenJetsFiller : public FillerBase {
   OutputSelector outputSelector_{};
 
   double minPt_{15.};
+
+  ObjectMap<reco::GenJet, panda::GenJet>* genJetMap_{0};
 };
 
 #endif
@@ -13,8 +13,11 @@ class GenParticlesFiller : public FillerBase {
 
   void branchNames(panda::utils::BranchList& eventBranches, panda::utils::BranchList&) const override;
   void fill(panda::Event&, edm::Event const&, edm::EventSetup const&) override;
+  int lastFillSize() const override { return nParticles_; }
 
  protected:
+  void bookObjectMaps_() override;
+
   typedef edm::View<reco::GenParticle> GenParticleView;
   typedef edm::View<pat::PackedGenParticle> PackedGenParticleView;
 
@@ -22,6 +25,10 @@ class GenParticlesFiller : public FillerBase {
   NamedToken<PackedGenParticleView> finalStateParticlesToken_;
 
   bool furtherPrune_{true};
+
+  int nParticles_{0};
+
+  ObjectMap<reco::Candidate, panda::GenParticle>* genParticleMap_{0};
 };
 
 #endif
@@ -19,6 +19,8 @@ class HLTFiller : public FillerBase {
   void notifyNewProduct(edm::BranchDescription const&, edm::ConsumesCollector&) override;
 
  protected:
+  void bookObjectMaps_() override;
+
   typedef edm::View<pat::TriggerObjectStandAlone> TriggerObjectView;
 
   NamedToken<edm::TriggerResults> triggerResultsToken_;
@@ -41,6 +43,9 @@ class HLTFiller : public FillerBase {
   // The vector needs to be a member data of this class to ensure validity of the pointer in
   // the objectMaps.
   std::vector<VString> filterNames_;
+
+  ObjectMap<pat::TriggerObjectStandAlone, panda::HLTObject>* objMap_{0};
+  ObjectMap<pat::TriggerObjectStandAlone, VString>* nameMap_{0};
 };
 
 #endif
@@ -20,8 +20,14 @@ class JetsFiller : public FillerBase {
   void branchNames(panda::utils::BranchList& eventBranches, panda::utils::BranchList&) const override;
   void fill(panda::Event&, edm::Event const&, edm::EventSetup const&) override;
   void setRefs(ObjectMapStore const&) override;
+  void resolveObjectMaps(ObjectMapStore const&) override;
+  void dependencies(VString&) const override;
+  void sharedResources(VString&) const override;
+  int lastFillSize() const override { return nJets_; }
 
  protected:
+  void bookObjectMaps_() override;
+
   virtual void fillDetails_(panda::Event&, edm::Event const&, edm::EventSetup const&) {}
 
   typedef edm::View<reco::Jet> JetView;
@@ -52,6 +58,14 @@ class JetsFiller : public FillerBase {
 
   bool fillConstituents_{false};
   unsigned subjetsOffset_{0}; // first N constituents are actually subjets (happens when fixDaughters = True in JetSubstructurePacker)
+
+  int nJets_{0};
+
+  ObjectMap<reco::Jet, panda::Jet>* jetMap_{0};
+  ObjectMap<reco::GenJet, panda::Jet>* genJetMap_{0};
+
+  ObjectMap<reco::Candidate, panda::PFCand> const* pfMap_{0};
+  ObjectMap<reco::GenJet, panda::GenJet> const* genMap_{0};
 };
 
 #endif
@@ -0,0 +1,51 @@
+#ifndef PandaProd_Producer_LatencyHistograms_h
+#define PandaProd_Producer_LatencyHistograms_h
+
+#include "TH1D.h"
+
+#include <string>
+#include <vector>
+#include <ostream>
+
+class TDirectory;
+
+//! Latency distributions of the filler steps
+/*!
+ * One histogram per filler and step (fillAll, fill, setRefs), named <filler>_<step>, filled in ms.
+ * Bins are fixed and logarithmic (10 per decade from 1 ns to 1000 s) so that histograms of different
+ * streams and jobs can be added. Calls outside of the range are counted in the first or last bin, so
+ * that every call enters the percentiles.
+ */
+class LatencyHistograms {
+ public:
+  enum Step {
+    kFillAll,
+    kFill,
+    kSetRefs,
+    nSteps
+  };
+
+  static char const* stepName(Step);
+
+  //! Histograms are attached to the directory if given, otherwise owned by this object
+  LatencyHistograms(std::vector<std::string> const& fillerNames, TDirectory* = 0);
+  ~LatencyHistograms();
+
+  //! Lower edge of the first and upper edge of the last bin
+  static constexpr double kMinMs = 1.e-6;
+  static constexpr double kMaxMs = 1.e6;
+
+  //! Record one call. Histograms of different fillers can be filled concurrently.
+  void fill(unsigned iF, Step step, double ms) { hists_[iF * nSteps + step]->Fill(ms < kMinMs ? kMinMs : (ms < kMaxMs ? ms : 0.9 * kMaxMs)); }
+  //! Add the contents of another set with the same fillers
+  void add(LatencyHistograms const&);
+  //! Print count, mean, and the 50, 95, and 99 percentiles per filler and step
+  void print(std::ostream&) const;
+
+ private:
+  std::vector<std::string> names_;
+  std::vector<TH1D*> hists_;
+  bool owned_;
+};
+
+#endif
@@ -6,6 +6,7 @@
 #include "DataFormats/Common/interface/View.h"
 #include "DataFormats/MuonReco/interface/Muon.h"
 #include "DataFormats/VertexReco/interface/VertexFwd.h"
+#include "DataFormats/PatCandidates/interface/TriggerObjectStandAlone.h"
 
 class MuonsFiller : public FillerBase {
  public:
@@ -16,14 +17,28 @@ class MuonsFiller : public FillerBase {
   void branchNames(panda::utils::BranchList& eventBranches, panda::utils::BranchList&) const override;
   void fill(panda::Event&, edm::Event const&, edm::EventSetup const&) override;
   void setRefs(ObjectMapStore const&) override;
+  void resolveObjectMaps(ObjectMapStore const&) override;
+  void dependencies(VString&) const override;
 
  protected:
+  void bookObjectMaps_() override;
+
   typedef edm::View<reco::Muon> MuonView;
 
   NamedToken<MuonView> muonsToken_;
   NamedToken<reco::VertexCollection> verticesToken_;
 
   std::set<std::string> triggerObjectNames_[panda::Muon::nTriggerObjects];
+
+  ObjectMap<reco::Muon, panda::Muon>* muMuMap_{0};
+  ObjectMap<reco::Candidate, panda::Muon>* pfMuMap_{0};
+  ObjectMap<reco::Vertex, panda::Muon>* vtxMuMap_{0};
+  ObjectMap<reco::Candidate, panda::Muon>* genMuMap_{0};
+
+  ObjectMap<reco::Candidate, panda::PFCand> const* pfMap_{0};
+  ObjectMap<reco::Vertex, panda::RecoVertex> const* vtxMap_{0};
+  ObjectMap<reco::Candidate, panda::GenParticle> const* genMap_{0};
+  ObjectMap<pat::TriggerObjectStandAlone, VString> const* hltNameMap_{0};
 };
 
 #endif
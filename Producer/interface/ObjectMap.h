@@ -4,10 +4,17 @@
 #include "DataFormats/Common/interface/Ptr.h"
 #include "PandaTree/Framework/interface/Object.h"
 
+#include <algorithm>
+#include <atomic>
+#include <functional>
 #include <map>
+#include <mutex>
+#include <stdexcept>
 #include <string>
 #include <tuple>
 #include <typeinfo>
+#include <utility>
+#include <vector>
 
 //! Abstract base to handle ObjectMaps for different types in a single container
 class ObjectMapBase {
@@ -23,18 +30,89 @@ class ObjectMapBase {
 };
 
 //! Actual EDM <-> panda map
+/*!
+ * Links are stored in a flat vector in the order of add(). The forward (edm -> panda) and backward
+ * (panda -> edm) views are built on their first use after a change: a copy of the links sorted by EDM Ptr
+ * and by panda pointer, keeping the first link added for a duplicate key, as std::map::emplace did.
+ * Forward lookups go through dense per-product vectors indexed by the Ptr key; transient Ptrs and
+ * unusually large keys are found by binary search instead. All buffers keep their capacity across events.
+ * add() must not be called concurrently with other calls, but the views can be read from several threads.
+ */
 template<class EDM, class PANDA>
 class ObjectMap : public ObjectMapBase {
+ public:
   typedef edm::Ptr<EDM> EDMPtr;
+  typedef std::pair<EDMPtr, PANDA*> FwdLink;
+  typedef std::pair<PANDA*, EDMPtr> BwdLink;
 
- public:
-  std::map<EDMPtr, PANDA*> fwdMap;
-  std::map<PANDA*, EDMPtr> bwdMap;
+  //! edm -> panda view with the std::map interface used by the fillers
+  class FwdView {
+   public:
+    typedef typename std::vector<FwdLink>::const_iterator const_iterator;
+
+    FwdView(ObjectMap const& _map) : map_(_map) {}
+
+    const_iterator begin() const { map_.freeze_(); return map_.fwd_.begin(); }
+    const_iterator end() const { map_.freeze_(); return map_.fwd_.end(); }
+    size_t size() const { map_.freeze_(); return map_.fwd_.size(); }
+    bool empty() const { return map_.links_.empty(); }
+    const_iterator find(EDMPtr const&) const;
+    //! Throws std::out_of_range if the Ptr is not in the map
+    PANDA* at(EDMPtr const&) const;
+
+   private:
+    ObjectMap const& map_;
+  };
+
+  //! panda -> edm view, ordered by panda pointer
+  class BwdView {
+   public:
+    typedef typename std::vector<BwdLink>::const_iterator const_iterator;
+
+    BwdView(ObjectMap const& _map) : map_(_map) {}
+
+    const_iterator begin() const { map_.freeze_(); return map_.bwd_.begin(); }
+    const_iterator end() const { map_.freeze_(); return map_.bwd_.end(); }
+    size_t size() const { map_.freeze_(); return map_.bwd_.size(); }
+    bool empty() const { return map_.links_.empty(); }
 
-  void clear() override { fwdMap.clear(); bwdMap.clear(); }
+   private:
+    ObjectMap const& map_;
+  };
+
+  ObjectMap() : fwdMap(*this), bwdMap(*this) {}
+  ObjectMap(ObjectMap const&) = delete;
+  ObjectMap& operator=(ObjectMap const&) = delete;
+
+  FwdView const fwdMap;
+  BwdView const bwdMap;
+
+  void clear() override;
   MapId getId() const override { return MapId(typeid(EDM).hash_code(), typeid(PANDA).hash_code(), label); }
 
-  void add(EDMPtr const& edmRef, PANDA& pandaObj) { fwdMap.emplace(edmRef, &pandaObj); bwdMap.emplace(&pandaObj, edmRef); }
+  void add(EDMPtr const& edmRef, PANDA& pandaObj) { links_.emplace_back(edmRef, &pandaObj); frozen_.store(false, std::memory_order_release); }
+
+ private:
+  //! Keys above this limit are looked up by binary search
+  static constexpr size_t kMaxDenseKey = 1 << 20;
+
+  struct ProductIndex {
+    edm::ProductID id;
+    std::vector<int> slots; //!< Ptr key -> index in fwd_, -1 if absent
+  };
+
+  //! Build the views if there were changes since the last call
+  void freeze_() const;
+  //! Dense slot of the Ptr; null if the Ptr is not indexed densely or (unless create) its slot does not exist
+  int* slot_(EDMPtr const&, bool create) const;
+
+  std::vector<FwdLink> links_{};
+
+  mutable std::vector<FwdLink> fwd_{};
+  mutable std::vector<BwdLink> bwd_{};
+  mutable std::vector<ProductIndex> products_{};
+  mutable std::atomic<bool> frozen_{true};
+  mutable std::mutex mutex_{};
 };
 
 //! ObjectMap for a single filler
@@ -49,10 +127,133 @@ class FillerObjectMap : public std::map<ObjectMapBase::MapId, ObjectMapBase*> {
 
   template<class EDM, class PANDA>
   ObjectMap<EDM, PANDA> const& get(std::string label = "") const;
+
+  //! Return the map if it was created, null otherwise
+  template<class EDM, class PANDA>
+  ObjectMap<EDM, PANDA> const* findMap(std::string const& label = "") const;
 };
 
 typedef std::map<std::string, FillerObjectMap> ObjectMapStore;
 
+template<class EDM, class PANDA>
+constexpr size_t ObjectMap<EDM, PANDA>::kMaxDenseKey;
+
+template<class EDM, class PANDA>
+void
+ObjectMap<EDM, PANDA>::clear()
+{
+  for (auto& link : fwd_) {
+    int* slot(slot_(link.first, false));
+    if (slot)
+      *slot = -1;
+  }
+
+  links_.clear();
+  fwd_.clear();
+  bwd_.clear();
+  frozen_.store(true, std::memory_order_release);
+}
+
+template<class EDM, class PANDA>
+void
+ObjectMap<EDM, PANDA>::freeze_() const
+{
+  if (frozen_.load(std::memory_order_acquire))
+    return;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (frozen_.load(std::memory_order_relaxed))
+    return;
+
+  for (auto& link : fwd_) {
+    int* slot(slot_(link.first, false));
+    if (slot)
+      *slot = -1;
+  }
+
+  // links are usually added in key order; stable sort + unique keeps the first link of each key
+  fwd_.assign(links_.begin(), links_.end());
+  auto fwdLess([](FwdLink const& l1, FwdLink const& l2) { return l1.first < l2.first; });
+  if (!std::is_sorted(fwd_.begin(), fwd_.end(), fwdLess))
+    std::stable_sort(fwd_.begin(), fwd_.end(), fwdLess);
+  fwd_.erase(std::unique(fwd_.begin(), fwd_.end(), [](FwdLink const& l1, FwdLink const& l2) { return l1.first == l2.first; }), fwd_.end());
+
+  for (unsigned iL(0); iL != fwd_.size(); ++iL) {
+    int* slot(slot_(fwd_[iL].first, true));
+    if (slot)
+      *slot = iL;
+  }
+
+  bwd_.clear();
+  for (auto& link : links_)
+    bwd_.emplace_back(link.second, link.first);
+  auto bwdLess([](BwdLink const& l1, BwdLink const& l2) { return std::less<PANDA*>()(l1.first, l2.first); });
+  if (!std::is_sorted(bwd_.begin(), bwd_.end(), bwdLess))
+    std::stable_sort(bwd_.begin(), bwd_.end(), bwdLess);
+  bwd_.erase(std::unique(bwd_.begin(), bwd_.end(), [](BwdLink const& l1, BwdLink const& l2) { return l1.first == l2.first; }), bwd_.end());
+
+  frozen_.store(true, std::memory_order_release);
+}
+
+template<class EDM, class PANDA>
+int*
+ObjectMap<EDM, PANDA>::slot_(EDMPtr const& _ptr, bool _create) const
+{
+  if (_ptr.isTransient() || _ptr.key() >= kMaxDenseKey)
+    return 0;
+
+  auto pItr(std::find_if(products_.begin(), products_.end(), [&_ptr](ProductIndex const& p) { return p.id == _ptr.id(); }));
+  if (pItr == products_.end()) {
+    if (!_create)
+      return 0;
+    products_.emplace_back();
+    pItr = products_.end() - 1;
+    pItr->id = _ptr.id();
+  }
+
+  auto& slots(pItr->slots);
+  if (_ptr.key() >= slots.size()) {
+    if (!_create)
+      return 0;
+    slots.resize(_ptr.key() + 1, -1);
+  }
+
+  return &slots[_ptr.key()];
+}
+
+template<class EDM, class PANDA>
+typename ObjectMap<EDM, PANDA>::FwdView::const_iterator
+ObjectMap<EDM, PANDA>::FwdView::find(EDMPtr const& _ptr) const
+{
+  map_.freeze_();
+
+  auto& fwd(map_.fwd_);
+
+  if (_ptr.isTransient() || _ptr.key() >= kMaxDenseKey) {
+    auto lItr(std::lower_bound(fwd.begin(), fwd.end(), _ptr, [](FwdLink const& l, EDMPtr const& p) { return l.first < p; }));
+    if (lItr != fwd.end() && lItr->first == _ptr)
+      return lItr;
+    return fwd.end();
+  }
+
+  int* slot(map_.slot_(_ptr, false));
+  if (!slot || *slot < 0)
+    return fwd.end();
+
+  return fwd.begin() + *slot;
+}
+
+template<class EDM, class PANDA>
+PANDA*
+ObjectMap<EDM, PANDA>::FwdView::at(EDMPtr const& _ptr) const
+{
+  auto lItr(find(_ptr));
+  if (lItr == map_.fwd_.end())
+    throw std::out_of_range("ObjectMap::at");
+
+  return lItr->second;
+}
+
 template<class EDM, class PANDA>
 ObjectMap<EDM, PANDA>&
 FillerObjectMap::get(std::string label/* = ""*/)
@@ -75,4 +276,17 @@ FillerObjectMap::get(std::string label/* = ""*/) const
   return static_cast<ObjectMap<EDM, PANDA> const&>(*at(id));
 }
 
+template<class EDM, class PANDA>
+ObjectMap<EDM, PANDA> const*
+FillerObjectMap::findMap(std::string const& label/* = ""*/) const
+{
+  ObjectMapBase::MapId id(typeid(EDM).hash_code(), typeid(PANDA).hash_code(), label);
+
+  auto sItr(find(id));
+  if (sItr == end())
+    return 0;
+
+  return static_cast<ObjectMap<EDM, PANDA> const*>(sItr->second);
+}
+
 #endif
@@ -0,0 +1,48 @@
+#ifndef PandaProd_Producer_OutputMerger_h
+#define PandaProd_Producer_OutputMerger_h
+
+#include <string>
+#include <vector>
+#include <set>
+
+class TFile;
+class TDirectory;
+
+//! Merges per-stream output segments into a single panda file
+/*!
+ * Each stream of a multi-threaded job writes its own segment file. At the end of the job the
+ * segments are combined in ascending stream index:
+ *  - "Event-like" trees (events by default) are fast-copied and concatenated. Segments without entries are
+ *    skipped; the others must have identical branches.
+ *  - lumiSummary entries with the same (runNumber, lumiNumber) are merged by summing all other leaves
+ *  - histograms with the same name are summed, also in subdirectories. 1D histograms with fully labeled bins
+ *    (e.g. hSumW, whose signal weight bins are learned per stream) are summed by label.
+ *  - all other trees (runs, hlt, weights, doc trees) are identical across streams and are taken from the first segment containing them
+ * A single segment is simply renamed to the output file name. Segments that cannot be combined throw.
+ */
+class OutputMerger {
+ public:
+  OutputMerger(std::string const& outputName);
+
+  //! Register a segment. Segments are merged in the order of registration.
+  void addSegment(std::string const& fileName) { segments_.push_back(fileName); }
+  //! Register an additional tree whose entries are concatenated
+  void addConcatenatedTree(std::string const& treeName) { concatenated_.push_back(treeName); }
+  //! Default compression settings of the output file (-1: ROOT default)
+  void setCompressionSettings(int settings) { compressionSettings_ = settings; }
+
+  //! Write the output file and delete the segments
+  void merge();
+
+ private:
+  void mergeDirectory_(TDirectory& output, std::vector<TDirectory*> const&, std::set<std::string> done) const;
+  void concatenate_(TFile& output, std::vector<TFile*> const&, std::string const& treeName) const;
+  void mergeLumiSummary_(TFile& output, std::vector<TFile*> const&) const;
+
+  std::string const outputName_;
+  std::vector<std::string> segments_{};
+  std::vector<std::string> concatenated_{"events"};
+  int compressionSettings_{-1};
+};
+
+#endif
@@ -7,6 +7,9 @@
 #include "DataFormats/VertexReco/interface/VertexFwd.h"
 #include "DataFormats/Common/interface/ValueMap.h"
 
+#include <vector>
+#include <map>
+
 class PFCandsFiller : public FillerBase {
  public:
   PFCandsFiller(std::string const&, edm::ParameterSet const&, edm::ConsumesCollector&);
@@ -15,12 +18,27 @@ class PFCandsFiller : public FillerBase {
   void branchNames(panda::utils::BranchList& eventBranches, panda::utils::BranchList&) const override;
   void fill(panda::Event&, edm::Event const&, edm::EventSetup const&) override;
   void setRefs(ObjectMapStore const&) override;
+  void resolveObjectMaps(ObjectMapStore const&) override;
+  void dependencies(VString&) const override;
+  void refBranches(VString&) const override;
+  int lastFillSize() const override { return nCandidates_; }
 
  protected:
+  void bookObjectMaps_() override;
+
   typedef edm::ValueMap<reco::CandidatePtr> CandidatePtrMap;
   typedef edm::View<reco::Vertex> VertexView;
   typedef edm::Ptr<reco::Vertex> VertexPtr;
 
+  //! fill puppiPtrs with the puppi candidates at the positions of the matching PF candidates
+  void associatePuppi_(edm::Handle<reco::CandidateView> const& candsHandle, CandidatePtrMap const&, edm::Handle<reco::CandidateView> const& inputHandle, std::vector<reco::CandidatePtr>& puppiPtrs, char const* inputName);
+  //! fill pfIndices_
+  void indexPFCandidates_(reco::CandidateView const&);
+  //! position of the candidate in the PF view, -1 if not found
+  int findPFIndex_(reco::CandidatePtr const&) const;
+  //! position of the PF candidate the candidate was cloned from, -1 if not found
+  int tracePFIndex_(reco::CandidatePtr const&);
+
   NamedToken<reco::CandidateView> candidatesToken_;
   NamedToken<CandidatePtrMap> puppiMapToken_;
   NamedToken<reco::CandidateView> puppiInputToken_;
@@ -30,9 +48,25 @@ class PFCandsFiller : public FillerBase {
 
   bool useExistingWeights_{true};
 
+  //! puppi candidates at the position of the PF candidate in the input view (empty if not configured)
+  std::vector<reco::CandidatePtr> puppiPtrs_{};
+  std::vector<reco::CandidatePtr> puppiNoLepPtrs_{};
+  //! position in the PF view, indexed by product ID and key of the Ptr to the original collection
+  std::vector<std::pair<edm::ProductID, std::vector<int>>> pfIndices_{};
+  bool pfIndexed_{false};
+  //! number of sourceCandidatePtr steps from a cloned puppi input product to the PF candidates
+  std::map<edm::ProductID, unsigned> sourceDepths_{};
+
   //! cache the candidate and vertex ordering (using ref keys) to use in setRefs
   panda::PFCandCollection* outCandidates_{};
   std::vector<VertexPtr> orderedVertices_{};
+
+  int nCandidates_{0};
+
+  ObjectMap<reco::Candidate, panda::PFCand>* pfMap_{0};
+  ObjectMap<reco::Candidate, panda::PFCand>* puppiMap_{0};
+
+  ObjectMap<reco::Vertex, panda::RecoVertex> const* vtxMap_{0};
 };
 
 #endif
@@ -0,0 +1,38 @@
+#ifndef PandaProd_Producer_PerfCounters_h
+#define PandaProd_Producer_PerfCounters_h
+
+#include <array>
+#include <vector>
+#include <string>
+#include <ostream>
+
+//! Hardware performance counters of the calling thread (Linux perf_event)
+/*!
+ * Counters are opened as one group per thread on first use and measure user-space activity of
+ * that thread only. Values are scaled for multiplexing. Counters that the kernel or CPU does
+ * not provide read as NaN; if no counter can be opened (non-Linux system, perf_event_paranoid
+ * too restrictive, containers without the syscall), read() returns false.
+ */
+class PerfCounters {
+ public:
+  enum Counter {
+    kCycles,
+    kInstructions,
+    kL1DMisses,
+    kLLCMisses,
+    kBranchMisses,
+    nCounters
+  };
+
+  typedef std::array<double, nCounters> Counts;
+
+  static char const* counterName(Counter);
+
+  //! Read the current counts of the calling thread
+  static bool read(Counts&);
+
+  //! Print per-event counts and IPC for each entry
+  static void print(std::ostream&, std::vector<std::string> const& names, std::vector<Counts> const&, unsigned long long nEvents);
+};
+
+#endif
@@ -7,8 +7,10 @@
 #include "DataFormats/Common/interface/ValueMap.h"
 #include "DataFormats/EgammaCandidates/interface/PhotonFwd.h"
 #include "DataFormats/EgammaCandidates/interface/GsfElectronFwd.h"
+#include "DataFormats/EgammaReco/interface/SuperClusterFwd.h"
 #include "DataFormats/EcalRecHit/interface/EcalRecHitCollections.h"
 #include "DataFormats/PatCandidates/interface/PackedGenParticle.h"
+#include "DataFormats/PatCandidates/interface/TriggerObjectStandAlone.h"
 #include "DataFormats/Candidate/interface/CandidateFwd.h"
 
 #include "RecoEgamma/EgammaTools/interface/EffectiveAreas.h"
@@ -24,8 +26,12 @@ class PhotonsFiller : public FillerBase {
   void branchNames(panda::utils::BranchList& eventBranches, panda::utils::BranchList&) const override;
   void fill(panda::Event&, edm::Event const&, edm::EventSetup const&) override;
   void setRefs(ObjectMapStore const&) override;
+  void resolveObjectMaps(ObjectMapStore const&) override;
+  void dependencies(VString&) const override;
 
  protected:
+  void bookObjectMaps_() override;
+
   typedef edm::View<reco::Photon> PhotonView;
   typedef edm::View<reco::GsfElectron> GsfElectronView;
   typedef edm::ValueMap<bool> BoolMap;
@@ -56,6 +62,16 @@ class PhotonsFiller : public FillerBase {
   TFormula phIsoLeakage_[2];
 
   std::set<std::string> triggerObjectNames_[panda::Photon::nTriggerObjects];
+
+  ObjectMap<reco::Photon, panda::Photon>* phoPhoMap_{0};
+  ObjectMap<reco::SuperCluster, panda::Photon>* scPhoMap_{0};
+  ObjectMap<reco::Candidate, panda::Photon>* pfPhoMap_{0};
+  ObjectMap<reco::Candidate, panda::Photon>* genPhoMap_{0};
+
+  ObjectMap<reco::SuperCluster, panda::SuperCluster> const* scMap_{0};
+  ObjectMap<reco::Candidate, panda::PFCand> const* pfMap_{0};
+  ObjectMap<reco::Candidate, panda::GenParticle> const* genMap_{0};
+  ObjectMap<pat::TriggerObjectStandAlone, VString> const* hltNameMap_{0};
 };
 
 #endif
@@ -17,11 +17,15 @@ class SuperClustersFiller : public FillerBase {
   void fill(panda::Event&, edm::Event const&, edm::EventSetup const&) override;
 
  protected:
+  void bookObjectMaps_() override;
+
   typedef edm::View<reco::SuperCluster> SuperClusterView;
 
   NamedToken<SuperClusterView> superClustersToken_;
   NamedToken<EcalRecHitCollection> ebHitsToken_;
   NamedToken<EcalRecHitCollection> eeHitsToken_;
+
+  ObjectMap<reco::SuperCluster, panda::SuperCluster>* scMap_{0};
 };
 
 #endif
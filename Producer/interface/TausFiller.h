@@ -6,6 +6,7 @@
 #include "DataFormats/Common/interface/View.h"
 #include "DataFormats/TauReco/interface/BaseTau.h"
 #include "DataFormats/HepMCCandidate/interface/GenParticle.h"
+#include "DataFormats/VertexReco/interface/VertexFwd.h"
 
 class TausFiller : public FillerBase {
  public:
@@ -15,13 +16,24 @@ class TausFiller : public FillerBase {
   void branchNames(panda::utils::BranchList& eventBranches, panda::utils::BranchList&) const override;
   void fill(panda::Event&, edm::Event const&, edm::EventSetup const&) override;
   void setRefs(ObjectMapStore const&) override;
+  void resolveObjectMaps(ObjectMapStore const&) override;
+  void dependencies(VString&) const override;
 
  protected:
+  void bookObjectMaps_() override;
+
   typedef edm::View<reco::BaseTau> TauView;
   typedef edm::View<reco::GenParticle> GenParticleView;
 
   NamedToken<TauView> tausToken_;
   NamedToken<GenParticleView> genParticlesToken_;
+
+  ObjectMap<reco::BaseTau, panda::Tau>* tauMap_{0};
+  ObjectMap<reco::Vertex, panda::Tau>* vtxTauMap_{0};
+  ObjectMap<reco::Candidate, panda::Tau>* genTauMap_{0};
+
+  ObjectMap<reco::Vertex, panda::RecoVertex> const* vtxMap_{0};
+  ObjectMap<reco::Candidate, panda::GenParticle> const* genMap_{0};
 };
 
 #endif
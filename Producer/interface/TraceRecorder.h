@@ -0,0 +1,51 @@
+#ifndef PandaProd_Producer_TraceRecorder_h
+#define PandaProd_Producer_TraceRecorder_h
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <ostream>
+
+//! Collects time spans and writes them in the Chrome trace-event JSON format
+/*!
+ * The output can be opened in chrome://tracing or ui.perfetto.dev. Spans are complete ("X") events
+ * with timestamps relative to a common origin. The process ID is the CMSSW stream and the thread ID
+ * is a job-wide index of the OS thread that recorded the span, so concurrently running fillers
+ * show up as parallel tracks.
+ */
+class TraceRecorder {
+ public:
+  typedef std::chrono::steady_clock Clock;
+
+  TraceRecorder(Clock::time_point origin, unsigned pid = 0);
+
+  Clock::time_point origin() const { return origin_; }
+
+  //! Record a span on the calling thread. Can be called concurrently.
+  void record(std::string const& name, char const* category, Clock::time_point begin, Clock::time_point end, unsigned long long eventNumber);
+  //! Take over the spans of another recorder
+  void append(TraceRecorder const&);
+  bool empty() const { return spans_.empty(); }
+
+  void write(std::ostream&) const;
+
+ private:
+  struct Span {
+    std::string name;
+    char const* category;
+    double begin; // us
+    double duration; // us
+    unsigned pid;
+    unsigned tid;
+    unsigned long long eventNumber;
+  };
+
+  Clock::time_point const origin_;
+  unsigned const pid_;
+
+  std::mutex mutex_{};
+  std::vector<Span> spans_{};
+};
+
+#endif
@@ -22,6 +22,8 @@ class VerticesFiller : public FillerBase {
   void fillAll(edm::Event const&, edm::EventSetup const&) override;
 
  protected:
+  void bookObjectMaps_() override;
+
   typedef edm::View<reco::Vertex> VertexView;
   typedef edm::ValueMap<float> VertexScore;
   typedef std::vector<PileupSummaryInfo> PUSummaryCollection;
@@ -39,6 +41,8 @@ class VerticesFiller : public FillerBase {
   //! fillAll and fill will collect identical information -> cache it in fillAll
   unsigned short npvCache_{0};
   unsigned short npvTrueCache_{0};
+
+  ObjectMap<reco::Vertex, panda::RecoVertex>* vtxMap_{0};
 };
 
 #endif
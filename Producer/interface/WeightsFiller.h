@@ -28,6 +28,8 @@ class WeightsFiller : public FillerBase {
   void fill(panda::Event&, edm::Event const&, edm::EventSetup const&) override;
   void fillEndRun(panda::Run&, edm::Run const&, edm::EventSetup const&) override;
   void notifyNewProduct(edm::BranchDescription const&, edm::ConsumesCollector&) override;
+  void setTreeEvent(panda::Event& _event) override { treeEvent_ = &_event; }
+  bool modifiesEventTree() const override;
 
  protected:
   void getLHEWeights_(LHEEventProduct const&);
@@ -52,6 +54,8 @@ class WeightsFiller : public FillerBase {
 
   // need to hold on to the output file handle
   TFile* outputFile_{0};
+  // genParam branch is booked on the event bound to the tree
+  panda::Event* treeEvent_{0};
 };
 
 #endif
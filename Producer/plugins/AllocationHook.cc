@@ -0,0 +1,152 @@
+// Allocation counting hook. Built as a plain shared library (no EDM plugin) and loaded with LD_PRELOAD.
+// See interface/AllocationHook.h.
+
+#include "../interface/AllocationHook.h"
+
+#include <cstddef>
+#include <cerrno>
+#include <new>
+
+extern "C" {
+  void* __libc_malloc(std::size_t);
+  void* __libc_calloc(std::size_t, std::size_t);
+  void* __libc_realloc(void*, std::size_t);
+  void* __libc_memalign(std::size_t, std::size_t);
+  void __libc_free(void*);
+}
+
+namespace {
+
+  // initial-exec TLS never allocates, so it is safe to use inside malloc
+  __thread PandaAllocCounts* currentScope __attribute__((tls_model("initial-exec"))) = 0;
+
+  inline
+  void
+  countAlloc(std::size_t _size)
+  {
+    if (currentScope) {
+      ++currentScope->nAlloc;
+      currentScope->bytes += _size;
+    }
+  }
+
+  inline
+  void
+  countFree(void* _ptr)
+  {
+    if (_ptr && currentScope)
+      ++currentScope->nFree;
+  }
+
+  void*
+  newImpl(std::size_t _size)
+  {
+    if (_size == 0)
+      _size = 1;
+
+    while (true) {
+      void* ptr(__libc_malloc(_size));
+      if (ptr) {
+        countAlloc(_size);
+        return ptr;
+      }
+
+      auto handler(std::get_new_handler());
+      if (!handler)
+        throw std::bad_alloc();
+      handler();
+    }
+  }
+
+}
+
+extern "C" {
+
+  PandaAllocCounts*
+  pandaAllocSetScope(PandaAllocCounts* _scope)
+  {
+    auto* previous(currentScope);
+    currentScope = _scope;
+    return previous;
+  }
+
+  void*
+  malloc(std::size_t _size)
+  {
+    void* ptr(__libc_malloc(_size));
+    if (ptr)
+      countAlloc(_size);
+    return ptr;
+  }
+
+  void*
+  calloc(std::size_t _n, std::size_t _size)
+  {
+    void* ptr(__libc_calloc(_n, _size));
+    if (ptr)
+      countAlloc(_n * _size);
+    return ptr;
+  }
+
+  void*
+  realloc(void* _ptr, std::size_t _size)
+  {
+    void* ptr(__libc_realloc(_ptr, _size));
+    if (ptr || _size == 0)
+      countFree(_ptr);
+    if (ptr)
+      countAlloc(_size);
+    return ptr;
+  }
+
+  void*
+  memalign(std::size_t _alignment, std::size_t _size)
+  {
+    void* ptr(__libc_memalign(_alignment, _size));
+    if (ptr)
+      countAlloc(_size);
+    return ptr;
+  }
+
+  void*
+  aligned_alloc(std::size_t _alignment, std::size_t _size)
+  {
+    return memalign(_alignment, _size);
+  }
+
+  int
+  posix_memalign(void** _ptr, std::size_t _alignment, std::size_t _size)
+  {
+    if (_alignment % sizeof(void*) != 0 || (_alignment & (_alignment - 1)) != 0)
+      return EINVAL;
+
+    void* ptr(memalign(_alignment, _size));
+    if (!ptr)
+      return ENOMEM;
+
+    *_ptr = ptr;
+    return 0;
+  }
+
+  void
+  free(void* _ptr)
+  {
+    countFree(_ptr);
+    __libc_free(_ptr);
+  }
+
+}
+
+// The C++ operators are replaced too, in case the executable links an allocator that overrides them
+
+void* operator new(std::size_t _size) { return newImpl(_size); }
+void* operator new[](std::size_t _size) { return newImpl(_size); }
+void* operator new(std::size_t _size, std::nothrow_t const&) noexcept { return malloc(_size == 0 ? 1 : _size); }
+void* operator new[](std::size_t _size, std::nothrow_t const&) noexcept { return malloc(_size == 0 ? 1 : _size); }
+
+void operator delete(void* _ptr) noexcept { free(_ptr); }
+void operator delete[](void* _ptr) noexcept { free(_ptr); }
+void operator delete(void* _ptr, std::nothrow_t const&) noexcept { free(_ptr); }
+void operator delete[](void* _ptr, std::nothrow_t const&) noexcept { free(_ptr); }
+void operator delete(void* _ptr, std::size_t) noexcept { free(_ptr); }
+void operator delete[](void* _ptr, std::size_t) noexcept { free(_ptr); }
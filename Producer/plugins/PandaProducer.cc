@@ -1,6 +1,6 @@
 #include "FWCore/Framework/interface/LuminosityBlock.h"
 #include "FWCore/Framework/interface/Frameworkfwd.h"
-#include "FWCore/Framework/interface/EDAnalyzer.h"
+#include "FWCore/Framework/interface/stream/EDAnalyzer.h"
 #include "FWCore/Framework/interface/Event.h"
 #include "FWCore/Framework/interface/Run.h"
 #include "FWCore/Framework/interface/MakerMacros.h"
@@ -13,6 +13,14 @@
 
 #include "../interface/FillerBase.h"
 #include "../interface/ObjectMap.h"
+#include "../interface/OutputMerger.h"
+#include "../interface/FillerScheduler.h"
+#include "../interface/AsyncEventWriter.h"
+#include "../interface/CompressionPolicy.h"
+#include "../interface/LatencyHistograms.h"
+#include "../interface/PerfCounters.h"
+#include "../interface/TraceRecorder.h"
+#include "../interface/AllocationHook.h"
 
 #include "TFile.h"
 #include "TTree.h"
@@ -20,6 +28,13 @@
 #include <vector>
 #include <utility>
 #include <chrono>
+#include <mutex>
+#include <memory>
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <dlfcn.h>
 
 typedef std::chrono::steady_clock SClock;
 double toMS(SClock::duration const& interval)
@@ -27,53 +42,183 @@ double toMS(SClock::duration const& interval)
   return std::chrono::duration_cast<std::chrono::nanoseconds>(interval).count() * 1.e-6;
 }
 
-class PandaProducer : public edm::EDAnalyzer {
+//! Directs the allocation counts of the current thread to the given counters while in scope
+class AllocationScope {
 public:
-  explicit PandaProducer(edm::ParameterSet const&);
+  AllocationScope(PandaAllocSetScopeFunc setScope, PandaAllocCounts* counts) :
+    setScope_(setScope),
+    previous_(setScope ? setScope(counts) : 0)
+  {}
+  ~AllocationScope()
+  {
+    if (setScope_)
+      setScope_(previous_);
+  }
+
+private:
+  PandaAllocSetScopeFunc setScope_;
+  PandaAllocCounts* previous_;
+};
+
+//! Job-wide state shared by all streams
+/*!
+ * Streams register their output segments, timers, and latency histograms here at endStream.
+ * The segments are merged into the final output file in globalEndJob.
+ */
+struct PandaProducerGlobal {
+  PandaProducerGlobal(edm::ParameterSet const&);
+
+  std::string segmentName(unsigned streamId) const;
+
+  std::string const outputName;
+  unsigned const printLevel;
+  CompressionPolicy const compression;
+  //! Trace-event output (empty -> no tracing) and the window of job-wide event indices to trace
+  std::string const traceFileName;
+  unsigned long long const traceFirstEvent;
+  unsigned long long const traceNEvents;
+
+  mutable std::mutex mutex{};
+  mutable std::vector<std::string> segments{}; //! indexed by stream ID
+  mutable std::vector<std::string> timerNames{};
+  mutable std::vector<SClock::duration> timers{};
+  mutable std::unique_ptr<LatencyHistograms> latency{};
+  mutable unsigned long long nEvents{0};
+  mutable unsigned long long nCMSSWSteps{0};
+  mutable std::vector<PerfCounters::Counts> perfCounts{}; //! indexed like timerNames
+  mutable unsigned long long nSelectedEvents{0};
+  mutable unsigned long long nSlowEvents{0};
+  mutable std::vector<PandaAllocCounts> allocCounts{}; //! indexed like timerNames
+  mutable std::atomic<unsigned long long> eventIndex{0};
+  mutable TraceRecorder trace{SClock::now()};
+};
+
+PandaProducerGlobal::PandaProducerGlobal(edm::ParameterSet const& _cfg) :
+  outputName(_cfg.getUntrackedParameter<std::string>("outputFile", "panda.root")),
+  printLevel(_cfg.getUntrackedParameter<unsigned>("printLevel", 0)),
+  compression(_cfg.getUntrackedParameter<edm::ParameterSet>("compression", edm::ParameterSet())),
+  traceFileName(_cfg.getUntrackedParameter<edm::ParameterSet>("trace", edm::ParameterSet()).getUntrackedParameter<std::string>("fileName", "")),
+  traceFirstEvent(_cfg.getUntrackedParameter<edm::ParameterSet>("trace", edm::ParameterSet()).getUntrackedParameter<unsigned>("firstEvent", 0)),
+  traceNEvents(_cfg.getUntrackedParameter<edm::ParameterSet>("trace", edm::ParameterSet()).getUntrackedParameter<unsigned>("nEvents", 100))
+{
+}
+
+std::string
+PandaProducerGlobal::segmentName(unsigned _streamId) const
+{
+  TString name(outputName);
+  if (name.EndsWith(".root"))
+    name.Remove(name.Length() - 5);
+
+  return TString::Format("%s_stream%u.root", name.Data(), _streamId).Data();
+}
+
+//! The ntuplizer module
+/*!
+ * Each stream owns its own fillers, object maps, panda::Event, and output segment file.
+ * Segments are merged into outputFile at the end of the job (see OutputMerger).
+ */
+class PandaProducer : public edm::stream::EDAnalyzer<edm::GlobalCache<PandaProducerGlobal>> {
+public:
+  explicit PandaProducer(edm::ParameterSet const&, PandaProducerGlobal const*);
   ~PandaProducer();
 
+  static std::unique_ptr<PandaProducerGlobal> initializeGlobalCache(edm::ParameterSet const&);
+  static void globalEndJob(PandaProducerGlobal*);
+
 private:
   void analyze(edm::Event const&, edm::EventSetup const&) override;
   void beginRun(edm::Run const&, edm::EventSetup const&) override;
   void endRun(edm::Run const&, edm::EventSetup const&) override;
   void beginLuminosityBlock(edm::LuminosityBlock const&, edm::EventSetup const&) override;
   void endLuminosityBlock(edm::LuminosityBlock const&, edm::EventSetup const&) override;
-  void beginJob() override;
-  void endJob() override;
+  void beginStream(edm::StreamID) override;
+  void endStream() override;
+
+  //! Call one step (fillAll, fill, setRefs) of filler iF with timing and error reporting
+  template<class Func> void runStep_(unsigned iF, LatencyHistograms::Step, Func const&);
+  //! Bookkeeping at every return from analyze()
+  void endAnalyze_(SClock::time_point const& analyzeStart, bool selected);
 
   std::vector<FillerBase*> fillers_;
+  //! Non-null when concurrentFillers = True
+  FillerScheduler* scheduler_{0};
+
   ObjectMapStore objectMaps_;
 
   VString selectEvents_;
   edm::EDGetTokenT<edm::TriggerResults> skimResultsToken_;
 
+  unsigned streamId_{0};
   TFile* outputFile_{0};
   TTree* eventTree_{0};
   TTree* runTree_{0};
   TTree* lumiSummaryTree_{0};
   TH1D* eventCounter_{0};
   panda::Event outEvent_;
+  //! Non-null when asyncWriteBuffers > 0
+  AsyncEventWriter* writer_{0};
+  unsigned nWriteBuffers_;
+
+  //! Output event being filled (outEvent_ or a buffer of writer_)
+  panda::Event* currentEvent_{0};
+  //! Event being processed (used by the scheduler steps)
+  edm::Event const* inEvent_{0};
+  edm::EventSetup const* inSetup_{0};
 
   unsigned nEventsInLumi_;
 
-  std::string outputName_;
   bool useTrigger_;
   unsigned printLevel_;
 
   std::vector<SClock::duration> timers_;
+  //! Latency histograms in the "timing" directory of the output
+  LatencyHistograms* latency_{0};
+  //! Time spent in each filler in the current lumi (ms), written to lumiSummary
+  std::vector<double> lumiFillerTime_;
+  //! Hardware counters summed over fill and setRefs of each filler (perfCounters = True)
+  bool usePerf_;
+  std::vector<PerfCounters::Counts> perfCounts_;
+  unsigned long long nSelected_{0};
+  //! Non-null when trace.fileName is set; tracing_ is true for events in the trace window
+  TraceRecorder* trace_{0};
+  bool tracing_{false};
+
+  //! Slow-event watchdog: events exceeding the total or any per-filler time (ms; 0 -> no check) go to the slowEvents tree
+  double slowEventThreshold_;
+  double slowFillerThreshold_;
+  TTree* slowEventsTree_{0};
+  struct {
+    UInt_t runNumber;
+    UInt_t lumiNumber;
+    ULong64_t eventNumber;
+    Double_t time;
+  } slowEvent_{};
+  //! Time spent in each filler (ms) and its lastFillSize() for the current event
+  std::vector<double> eventFillerTime_;
+  std::vector<int> eventFillerSize_;
+  unsigned long long nSlowEvents_{0};
+
+  //! Non-null when allocationTracking = True and the hook library is preloaded
+  PandaAllocSetScopeFunc allocSetScope_{0};
+  //! Allocations in fill and setRefs of each filler
+  std::vector<PandaAllocCounts> allocCounts_;
   SClock::time_point lastAnalyze_; //! Time point of last return from analyze()
   unsigned long long nEvents_;
 };
 
-PandaProducer::PandaProducer(edm::ParameterSet const& _cfg) :
+PandaProducer::PandaProducer(edm::ParameterSet const& _cfg, PandaProducerGlobal const*) :
   selectEvents_(_cfg.getUntrackedParameter<VString>("SelectEvents")),
   skimResultsToken_(consumes<edm::TriggerResults>(edm::InputTag("TriggerResults"))), // no process name -> pick up the trigger results from the current process
   outEvent_(),
+  nWriteBuffers_(_cfg.getUntrackedParameter<unsigned>("asyncWriteBuffers", 0)),
   nEventsInLumi_(0),
-  outputName_(_cfg.getUntrackedParameter<std::string>("outputFile", "panda.root")),
   useTrigger_(_cfg.getUntrackedParameter<bool>("useTrigger", true)),
   printLevel_(_cfg.getUntrackedParameter<unsigned>("printLevel", 0)),
   timers_(),
+  usePerf_(_cfg.getUntrackedParameter<bool>("perfCounters", false)),
+  slowEventThreshold_(_cfg.getUntrackedParameter<edm::ParameterSet>("slowEvents", edm::ParameterSet()).getUntrackedParameter<double>("eventThreshold", 0.)),
+  slowFillerThreshold_(_cfg.getUntrackedParameter<edm::ParameterSet>("slowEvents", edm::ParameterSet()).getUntrackedParameter<double>("fillerThreshold", 0.)),
   lastAnalyze_(),
   nEvents_(0)
 {
@@ -105,12 +250,10 @@ PandaProducer::PandaProducer(edm::ParameterSet const& _cfg) :
       if (filler->enabled())
         filler->setObjectMap(objectMaps_[fillerName]);
 
-      if (printLevel_ >= 1) {
-        timers_.push_back(SClock::duration::zero());
+      timers_.push_back(SClock::duration::zero());
 
-        if (printLevel_ >= 3)
-          std::cout << "Initializing " << fillerName << " took " << toMS(SClock::now() - start) << " ms." << std::endl;
-      }
+      if (printLevel_ >= 3)
+        std::cout << "Initializing " << fillerName << " took " << toMS(SClock::now() - start) << " ms." << std::endl;
     }
     catch (std::exception& ex) {
       std::cerr << "[PandaProducer::PandaProducer] " 
@@ -120,9 +263,61 @@ PandaProducer::PandaProducer(edm::ParameterSet const& _cfg) :
     }
   }
 
-  if (printLevel_ >= 1) {
-    // timer for the CMSSW execution outside of this module
-    timers_.push_back(SClock::duration::zero());
+  // all maps are booked; fillers can now hold on to the maps of other fillers
+  for (auto* filler : fillers_) {
+    if (!filler->enabled())
+      continue;
+
+    try {
+      filler->resolveObjectMaps(objectMaps_);
+    }
+    catch (std::exception& ex) {
+      std::cerr << "[PandaProducer::PandaProducer] " 
+        << "Configuration error in " << filler->getName() << ":"
+                                     << ex.what() << std::endl;
+      throw;
+    }
+  }
+
+  lumiFillerTime_.assign(fillers_.size(), 0.);
+  eventFillerTime_.assign(fillers_.size(), 0.);
+  eventFillerSize_.assign(fillers_.size(), -1);
+
+  if (_cfg.getUntrackedParameter<bool>("allocationTracking", false)) {
+    allocSetScope_ = reinterpret_cast<PandaAllocSetScopeFunc>(dlsym(RTLD_DEFAULT, "pandaAllocSetScope"));
+    if (allocSetScope_)
+      allocCounts_.assign(fillers_.size(), PandaAllocCounts{0, 0, 0});
+    else
+      std::cerr << "[PandaProducer::PandaProducer] "
+                << "allocationTracking requires libPandaProdAllocationHook.so in LD_PRELOAD; allocations will not be counted" << std::endl;
+  }
+
+  if (usePerf_) {
+    PerfCounters::Counts zero;
+    zero.fill(0.);
+    perfCounts_.assign(fillers_.size(), zero);
+  }
+
+  // timer for the CMSSW execution outside of this module
+  timers_.push_back(SClock::duration::zero());
+
+  if (_cfg.getUntrackedParameter<bool>("concurrentFillers", false)) {
+    scheduler_ = new FillerScheduler(fillers_,
+                                     [this](unsigned iF) {
+                                       this->runStep_(iF, LatencyHistograms::kFill, [this](FillerBase& filler) {
+                                           filler.fill(*this->currentEvent_, *this->inEvent_, *this->inSetup_);
+                                         });
+                                     },
+                                     [this](unsigned iF) {
+                                       this->runStep_(iF, LatencyHistograms::kSetRefs, [this](FillerBase& filler) {
+                                           filler.setRefs(this->objectMaps_);
+                                         });
+                                     });
+
+    if (printLevel_ >= 1) {
+      std::cout << "[PandaProducer::PandaProducer] Filler dependency graph" << std::endl;
+      scheduler_->print(std::cout);
+    }
   }
 
   // The lambda function inside will be called by CMSSW Framework whenever a new product is registered
@@ -135,71 +330,75 @@ PandaProducer::PandaProducer(edm::ParameterSet const& _cfg) :
 
 PandaProducer::~PandaProducer()
 {
+  delete scheduler_;
+  delete writer_;
+  delete latency_;
+  delete trace_;
+
   for (auto* filler : fillers_)
     delete filler;
 }
 
+/*static*/
+std::unique_ptr<PandaProducerGlobal>
+PandaProducer::initializeGlobalCache(edm::ParameterSet const& _cfg)
+{
+  return std::unique_ptr<PandaProducerGlobal>(new PandaProducerGlobal(_cfg));
+}
+
 void
 PandaProducer::analyze(edm::Event const& _event, edm::EventSetup const& _setup)
 {
-  eventCounter_->Fill(0.5);
-  
-  if (printLevel_ >= 1) {
-    if (nEvents_ == 0) {
-      if (printLevel_ >= 3)
-        std::cout << "[PandaProducer::analyze] "
-                  << "First event; CMSSW step time unknown" << std::endl;
+  auto analyzeStart(SClock::now());
 
-    }
-    else {
-      auto dt(SClock::now() - lastAnalyze_);
-      if (printLevel_ >= 3)
-        std::cout << "[PandaProducer::analyze] "
-                  << "Previous (CMSSW) step took " << toMS(dt) << " ms" << std::endl;
+  eventCounter_->Fill(0.5);
 
-      timers_.back() += dt;
-    }
+  if (trace_) {
+    auto& global(*globalCache());
+    auto index(global.eventIndex++);
+    tracing_ = index >= global.traceFirstEvent && index - global.traceFirstEvent < global.traceNEvents;
   }
 
-  ++nEvents_;
-  ++nEventsInLumi_;
-
-  SClock::time_point start;
-
-  // Fill "all events" information
-  for (unsigned iF(0); iF != fillers_.size(); ++iF) {
-    auto* filler(fillers_[iF]);
+  if (nEvents_ == 0) {
+    if (printLevel_ >= 3)
+      std::cout << "[PandaProducer::analyze] "
+                << "First event; CMSSW step time unknown" << std::endl;
+  }
+  else {
+    auto dt(analyzeStart - lastAnalyze_);
+    if (printLevel_ >= 3)
+      std::cout << "[PandaProducer::analyze] "
+                << "Previous (CMSSW) step took " << toMS(dt) << " ms" << std::endl;
 
-    if (!filler->enabled())
-      continue;
+    timers_.back() += dt;
 
-    try {
-      if (printLevel_ >= 1) {
-        start = SClock::now();
+    if (tracing_)
+      trace_->record("Other CMSSW", "cmssw", lastAnalyze_, analyzeStart, _event.id().event());
+  }
 
-        if (printLevel_ >= 2)
-          std::cout << "[PandaProducer::analyze] " 
-                    << "Calling " << filler->getName() << "->fillAll()" << std::endl;
-      }
+  ++nEvents_;
+  ++nEventsInLumi_;
 
-      filler->fillAll(_event, _setup);
+  if (slowEventsTree_)
+    std::fill(eventFillerTime_.begin(), eventFillerTime_.end(), 0.);
 
-      if (printLevel_ >= 1) {
-        auto dt(SClock::now() - start);
+  inEvent_ = &_event;
+  inSetup_ = &_setup;
 
-        if (printLevel_ >= 3) {
-          std::cout << "[PandaProducer::analyze] " 
-                    << "Step " << filler->getName() << "->fillAll() took " << toMS(dt) << " ms" << std::endl;
-        }
-        
-        timers_[iF] += dt;
+  if (writer_) {
+    // complete pending writes if a filler is about to modify the events tree
+    for (auto* filler : fillers_) {
+      if (filler->enabled() && filler->modifiesEventTree()) {
+        writer_->drain();
+        break;
       }
     }
-    catch (std::exception& ex) {
-      std::cerr << "[PandaProducer::analyze] " 
-        << "Error in " << filler->getName() << "::fillAll()" << std::endl;
-      throw;
-    }
+  }
+
+  // Fill "all events" information
+  for (unsigned iF(0); iF != fillers_.size(); ++iF) {
+    if (fillers_[iF]->enabled())
+      runStep_(iF, LatencyHistograms::kFillAll, [&_event, &_setup](FillerBase& filler) { filler.fillAll(_event, _setup); });
   }
 
   // If path names are given, check if at least one succeeded
@@ -213,101 +412,176 @@ PandaProducer::analyze(edm::Event const& _event, edm::EventSetup const& _setup)
         if (iP != pathNames.size() && triggerResults->accept(iP))
           break;
       }
-      if (iS == selectEvents_.size())
+      if (iS == selectEvents_.size()) {
+        endAnalyze_(analyzeStart, false);
         return;
+      }
     }
   }
 
   eventCounter_->Fill(1.5);
+  ++nSelected_;
 
   // Now fill the event
-  outEvent_.init();
+  if (writer_)
+    currentEvent_ = &writer_->acquire();
+  else
+    currentEvent_ = &outEvent_;
+
+  currentEvent_->init();
 
   for (auto& mm : objectMaps_)
     mm.second.clearMaps();
 
-  outEvent_.runNumber = _event.id().run();
-  outEvent_.lumiNumber = _event.luminosityBlock();
-  outEvent_.eventNumber = _event.id().event();
-  outEvent_.isData = _event.isRealData();
+  currentEvent_->runNumber = _event.id().run();
+  currentEvent_->lumiNumber = _event.luminosityBlock();
+  currentEvent_->eventNumber = _event.id().event();
+  currentEvent_->isData = _event.isRealData();
 
-  for (unsigned iF(0); iF != fillers_.size(); ++iF) {
-    auto* filler(fillers_[iF]);
+  if (scheduler_)
+    scheduler_->run();
+  else {
+    for (unsigned iF(0); iF != fillers_.size(); ++iF) {
+      if (fillers_[iF]->enabled())
+        runStep_(iF, LatencyHistograms::kFill, [this, &_event, &_setup](FillerBase& filler) { filler.fill(*this->currentEvent_, _event, _setup); });
+    }
 
-    if (!filler->enabled())
-      continue;
+    // Set inter-branch references
+    for (unsigned iF(0); iF != fillers_.size(); ++iF) {
+      if (fillers_[iF]->enabled())
+        runStep_(iF, LatencyHistograms::kSetRefs, [this](FillerBase& filler) { filler.setRefs(this->objectMaps_); });
+    }
+  }
 
-    try {
-      if (printLevel_ >= 1) {
-        if (printLevel_ >= 2)
-          std::cout << "[PandaProducer::fill] " 
-                    << "Calling " << filler->getName() << "->fill()" << std::endl;
+  auto fillStart(SClock::now());
 
-        start = SClock::now();
-      }
+  if (writer_)
+    writer_->submit();
+  else
+    outEvent_.fill(*eventTree_);
 
-      filler->fill(outEvent_, _event, _setup);
+  if (tracing_)
+    trace_->record(writer_ ? "submit" : "tree fill", "output", fillStart, SClock::now(), _event.id().event());
 
-      if (printLevel_ >= 1) {
-        auto dt(SClock::now() - start);
+  endAnalyze_(analyzeStart, true);
+}
 
-        if (printLevel_ >= 3)
-          std::cout << "[PandaProducer::analyze] " 
-                    << "Step " << filler->getName() << "->fill() took " << toMS(dt) << " ms" << std::endl;
+void
+PandaProducer::endAnalyze_(SClock::time_point const& _analyzeStart, bool _selected)
+{
+  lastAnalyze_ = SClock::now();
+
+  auto id(inEvent_->id());
+
+  if (tracing_)
+    trace_->record(TString::Format("event %u:%u:%llu", id.run(), id.luminosityBlock(), id.event()).Data(), "event", _analyzeStart, lastAnalyze_, id.event());
 
-        timers_[iF] += dt;
+  if (!slowEventsTree_)
+    return;
+
+  double total(toMS(lastAnalyze_ - _analyzeStart));
+
+  bool slow(slowEventThreshold_ > 0. && total > slowEventThreshold_);
+  if (!slow && slowFillerThreshold_ > 0.) {
+    for (double ms : eventFillerTime_) {
+      if (ms > slowFillerThreshold_) {
+        slow = true;
+        break;
       }
     }
-    catch (std::exception& ex) {
-      std::cerr << "[PandaProducer::fill] " 
-        << "Error in " << filler->getName() << "::fill()" << std::endl;
-      throw;
-    }
   }
 
-  // Set inter-branch references
+  if (!slow)
+    return;
+
+  slowEvent_.runNumber = id.run();
+  slowEvent_.lumiNumber = id.luminosityBlock();
+  slowEvent_.eventNumber = id.event();
+  slowEvent_.time = total;
+
   for (unsigned iF(0); iF != fillers_.size(); ++iF) {
-    auto* filler(fillers_[iF]);
+    if (_selected && fillers_[iF]->enabled())
+      eventFillerSize_[iF] = fillers_[iF]->lastFillSize();
+    else
+      eventFillerSize_[iF] = -1;
+  }
 
-    if (!filler->enabled())
-      continue;
+  if (printLevel_ >= 1)
+    std::cout << "[PandaProducer::analyze] "
+              << "Slow event " << id.run() << ":" << id.luminosityBlock() << ":" << id.event() << " took " << total << " ms" << std::endl;
 
-    try {
-      if (printLevel_ >= 1) {
-        if (printLevel_ >= 2)
-          std::cout << "[PandaProducer:fill] "
-                    << "Calling " << filler->getName() << "->setRefs()" << std::endl;
+  // the events tree of the same file may be written from the writer thread
+  if (writer_)
+    writer_->drain();
 
-        start = SClock::now();
-      }
+  slowEventsTree_->Fill();
+  ++nSlowEvents_;
+}
+
+template<class Func>
+void
+PandaProducer::runStep_(unsigned _iF, LatencyHistograms::Step _step, Func const& _func)
+{
+  auto& filler(*fillers_[_iF]);
+  char const* stepName(LatencyHistograms::stepName(_step));
 
-      filler->setRefs(objectMaps_);
+  try {
+    if (printLevel_ >= 2)
+      std::cout << "[PandaProducer::analyze] "
+                << "Calling " << filler.getName() << "->" << stepName << "()" << std::endl;
 
-      if (printLevel_ >= 1) {
-        auto dt(SClock::now() - start);
+    // counters are read outside of the timed region to keep the syscalls out of the latencies
+    PerfCounters::Counts perfBefore;
+    bool countPerf(usePerf_ && _step != LatencyHistograms::kFillAll && PerfCounters::read(perfBefore));
 
-        if (printLevel_ >= 3)
-          std::cout << "[PandaProducer::analyze] " 
-                    << "Step " << filler->getName() << "->setRefs() took " << toMS(dt) << " ms" << std::endl;
+    auto start(SClock::now());
 
-        timers_[iF] += dt;
-      }
+    {
+      bool countAlloc(allocSetScope_ && _step != LatencyHistograms::kFillAll);
+      AllocationScope allocScope(countAlloc ? allocSetScope_ : 0, countAlloc ? &allocCounts_[_iF] : 0);
+
+      _func(filler);
     }
-    catch (std::exception& ex) {
-      std::cerr << "[PandaProducer:fill] " 
-        << "Error in " << filler->getName() << "::setRefs()" << std::endl;
-      throw;
+
+    auto dt(SClock::now() - start);
+    double ms(toMS(dt));
+
+    PerfCounters::Counts perfAfter;
+    if (countPerf && PerfCounters::read(perfAfter)) {
+      // the counters are per thread and cover the step only as long as it runs on this thread;
+      // work handed to TBB tasks (FatJetsFiller with parallelTopTagger) is missing, as are its allocations,
+      // while unrelated tasks this thread runs as it waits for them are included
+      for (unsigned iC(0); iC != PerfCounters::nCounters; ++iC)
+        perfCounts_[_iF][iC] += perfAfter[iC] - perfBefore[iC];
     }
-  }
 
-  outEvent_.fill(*eventTree_);
+    if (printLevel_ >= 3)
+      std::cout << "[PandaProducer::analyze] "
+                << "Step " << filler.getName() << "->" << stepName << "() took " << ms << " ms" << std::endl;
 
-  lastAnalyze_ = SClock::now();
+    // steps of one filler never run concurrently; steps of different fillers touch different slots
+    timers_[_iF] += dt;
+    lumiFillerTime_[_iF] += ms;
+    eventFillerTime_[_iF] += ms;
+    latency_->fill(_iF, _step, ms);
+
+    if (tracing_)
+      trace_->record(filler.getName() + "::" + stepName, stepName, start, start + dt, inEvent_->id().event());
+  }
+  catch (std::exception& ex) {
+    std::cerr << "[PandaProducer::analyze] "
+              << "Error in " << filler.getName() << "::" << stepName << "()" << std::endl;
+    throw;
+  }
 }
 
 void
 PandaProducer::beginRun(edm::Run const& _run, edm::EventSetup const& _setup)
 {
+  // fillers may write to other trees of the output file
+  if (writer_)
+    writer_->drain();
+
   outEvent_.run.init();
 
   outEvent_.run.runNumber = _run.run();
@@ -334,6 +608,9 @@ PandaProducer::beginRun(edm::Run const& _run, edm::EventSetup const& _setup)
 void
 PandaProducer::endRun(edm::Run const& _run, edm::EventSetup const& _setup)
 {
+  if (writer_)
+    writer_->drain();
+
   for (auto* filler : fillers_) {
     if (!filler->enabled())
       continue;
@@ -359,20 +636,28 @@ void
 PandaProducer::beginLuminosityBlock(edm::LuminosityBlock const& _lumi, edm::EventSetup const& _setup)
 {
   nEventsInLumi_ = 0;
+  // the lumiSummary branch points to the vector data; do not reallocate
+  std::fill(lumiFillerTime_.begin(), lumiFillerTime_.end(), 0.);
 }
 
 void
 PandaProducer::endLuminosityBlock(edm::LuminosityBlock const& _lumi, edm::EventSetup const& _setup)
 {
+  if (writer_)
+    writer_->drain();
+
   outEvent_.runNumber = _lumi.id().run();
   outEvent_.lumiNumber = _lumi.id().luminosityBlock();
   lumiSummaryTree_->Fill();
 }
 
 void 
-PandaProducer::beginJob()
+PandaProducer::beginStream(edm::StreamID _streamId)
 {
-  outputFile_ = TFile::Open(outputName_.c_str(), "recreate");
+  streamId_ = _streamId.value();
+
+  outputFile_ = TFile::Open(globalCache()->segmentName(streamId_).c_str(), "recreate");
+  globalCache()->compression.configure(*outputFile_);
   eventTree_ = new TTree("events", "");
   runTree_ = new TTree("runs", "");
   lumiSummaryTree_ = new TTree("lumiSummary", "");
@@ -384,16 +669,72 @@ PandaProducer::beginJob()
       filler->branchNames(eventBranches, runBranches);
   }
 
-  outEvent_.book(*eventTree_, eventBranches);
+  if (nWriteBuffers_ != 0) {
+    writer_ = new AsyncEventWriter(*eventTree_, eventBranches, nWriteBuffers_);
+    for (auto* filler : fillers_)
+      filler->setTreeEvent(writer_->treeEvent());
+  }
+  else {
+    outEvent_.book(*eventTree_, eventBranches);
+    for (auto* filler : fillers_)
+      filler->setTreeEvent(outEvent_);
+  }
+
   outEvent_.run.book(*runTree_, runBranches);
 
   lumiSummaryTree_->Branch("runNumber", &outEvent_.runNumber, "runNumber/i");
   lumiSummaryTree_->Branch("lumiNumber", &outEvent_.lumiNumber, "lumiNumber/i");
   lumiSummaryTree_->Branch("nEvents", &nEventsInLumi_, "nEventsInLumi_/i");
+  if (!fillers_.empty()) {
+    // names of the array elements are stored in the fillerNames tree
+    lumiSummaryTree_->Branch("fillerTime", lumiFillerTime_.data(), TString::Format("fillerTime[%d]/D", int(fillers_.size())));
+
+    auto* namesTree(new TTree("fillerNames", "Filler names of the lumiSummary and slowEvents arrays"));
+    TString name;
+    namesTree->Branch("name", "TString", &name);
+    for (auto* filler : fillers_) {
+      name = filler->getName();
+      namesTree->Fill();
+    }
+    namesTree->ResetBranchAddresses();
+  }
+
+  std::vector<std::string> fillerNames;
+  for (auto* filler : fillers_)
+    fillerNames.push_back(filler->getName());
+
+  latency_ = new LatencyHistograms(fillerNames, outputFile_->mkdir("timing"));
+
+  if (slowEventThreshold_ > 0. || slowFillerThreshold_ > 0.) {
+    outputFile_->cd();
+    slowEventsTree_ = new TTree("slowEvents", "Events exceeding the time thresholds");
+    slowEventsTree_->Branch("runNumber", &slowEvent_.runNumber, "runNumber/i");
+    slowEventsTree_->Branch("lumiNumber", &slowEvent_.lumiNumber, "lumiNumber/i");
+    slowEventsTree_->Branch("eventNumber", &slowEvent_.eventNumber, "eventNumber/l");
+    slowEventsTree_->Branch("time", &slowEvent_.time, "time/D");
+    if (!fillers_.empty()) {
+      slowEventsTree_->Branch("fillerTime", eventFillerTime_.data(), TString::Format("fillerTime[%d]/D", int(fillers_.size())));
+      slowEventsTree_->Branch("fillerSize", eventFillerSize_.data(), TString::Format("fillerSize[%d]/I", int(fillers_.size())));
+    }
+  }
+
+  if (!globalCache()->traceFileName.empty())
+    trace_ = new TraceRecorder(globalCache()->trace.origin(), streamId_);
+
+  if (usePerf_) {
+    PerfCounters::Counts counts;
+    if (!PerfCounters::read(counts)) {
+      std::cerr << "[PandaProducer::beginStream] "
+                << "Hardware performance counters are not available; perfCounters disabled" << std::endl;
+      usePerf_ = false;
+    }
+  }
 
   for (auto* filler : fillers_)
     filler->addOutput(*outputFile_);
 
+  globalCache()->compression.configure(*eventTree_);
+
   if (useTrigger_ && outputFile_->Get("hlt")) {
     outEvent_.run.hlt.create();
     auto& hltTree(*static_cast<TTree*>(outputFile_->Get("hlt")));
@@ -409,27 +750,128 @@ PandaProducer::beginJob()
 }
 
 void 
-PandaProducer::endJob()
+PandaProducer::endStream()
 {
-  // writes out all outputs that are still hanging in the directory
+  if (writer_) {
+    // rethrows errors of the writer thread
+    writer_->drain();
+    delete writer_;
+    writer_ = 0;
+  }
+
+  auto& global(*globalCache());
+
+  {
+    std::lock_guard<std::mutex> lock(global.mutex);
+
+    if (global.segments.size() <= streamId_)
+      global.segments.resize(streamId_ + 1);
+    global.segments[streamId_] = global.segmentName(streamId_);
+
+    if (global.timers.empty()) {
+      std::vector<std::string> fillerNames;
+      for (auto* filler : fillers_)
+        fillerNames.push_back(filler->getName());
+
+      global.timerNames = fillerNames;
+      global.timers.assign(timers_.size(), SClock::duration::zero());
+      global.latency.reset(new LatencyHistograms(fillerNames));
+    }
+
+    for (unsigned iT(0); iT != timers_.size(); ++iT)
+      global.timers[iT] += timers_[iT];
+
+    global.latency->add(*latency_);
+
+    if (usePerf_) {
+      if (global.perfCounts.empty())
+        global.perfCounts = perfCounts_;
+      else {
+        for (unsigned iF(0); iF != perfCounts_.size(); ++iF) {
+          for (unsigned iC(0); iC != PerfCounters::nCounters; ++iC)
+            global.perfCounts[iF][iC] += perfCounts_[iF][iC];
+        }
+      }
+    }
+
+    global.nSelectedEvents += nSelected_;
+    global.nSlowEvents += nSlowEvents_;
+
+    if (allocSetScope_) {
+      if (global.allocCounts.empty())
+        global.allocCounts = allocCounts_;
+      else {
+        for (unsigned iF(0); iF != allocCounts_.size(); ++iF) {
+          global.allocCounts[iF].nAlloc += allocCounts_[iF].nAlloc;
+          global.allocCounts[iF].nFree += allocCounts_[iF].nFree;
+          global.allocCounts[iF].bytes += allocCounts_[iF].bytes;
+        }
+      }
+    }
+
+    if (trace_)
+      global.trace.append(*trace_);
+
+    global.nEvents += nEvents_;
+    if (nEvents_ > 1)
+      global.nCMSSWSteps += nEvents_ - 1;
+  }
+
+  // writes out all outputs that are still hanging in the directory (histograms of latency_ are owned by the file)
   outputFile_->cd();
   outputFile_->Write();
   delete outputFile_;
+  outputFile_ = 0;
+
+  delete latency_;
+  latency_ = 0;
+}
+
+/*static*/
+void
+PandaProducer::globalEndJob(PandaProducerGlobal* _global)
+{
+  OutputMerger merger(_global->outputName);
+  merger.addConcatenatedTree("slowEvents");
+  merger.setCompressionSettings(_global->compression.fileSettings());
+  for (auto& segment : _global->segments) {
+    // streams that never started have no segment
+    if (!segment.empty())
+      merger.addSegment(segment);
+  }
+
+  merger.merge();
+
+  if (_global->nSlowEvents != 0)
+    std::cout << "[PandaProducer::endJob] " << _global->nSlowEvents << " slow events recorded in the slowEvents tree" << std::endl;
+
+  if (!_global->traceFileName.empty() && !_global->trace.empty()) {
+    std::ofstream traceFile(_global->traceFileName);
+    _global->trace.write(traceFile);
+    std::cout << "[PandaProducer::endJob] Event timeline written to " << _global->traceFileName << std::endl;
+  }
 
-  if (printLevel_ >= 1) {
+  if (_global->compression.doReport()) {
+    std::unique_ptr<TFile> output(TFile::Open(_global->outputName.c_str()));
+    auto* eventTree(output ? static_cast<TTree*>(output->Get("events")) : 0);
+    if (eventTree)
+      _global->compression.report(*eventTree, std::cout);
+  }
+
+  if (_global->printLevel >= 1 && _global->nEvents != 0) {
     double total(0.);
 
     std::cout << "[PandaProducer::endJob] Timer summary" << std::endl;
-    for (unsigned iF(0); iF != fillers_.size(); ++iF) {
-      double msPerEvt(toMS(timers_[iF]) / nEvents_);
-      std::cout << " " << fillers_[iF]->getName() << "  "
+    for (unsigned iF(0); iF != _global->timerNames.size(); ++iF) {
+      double msPerEvt(toMS(_global->timers[iF]) / _global->nEvents);
+      std::cout << " " << _global->timerNames[iF] << "  "
                 << std::fixed << std::setprecision(3) << msPerEvt << " ms/evt"
                 << std::endl;
 
       total += msPerEvt;
     }
-    if (nEvents_ > 1) {
-      double msPerEvt(toMS(timers_.back()) / (nEvents_ - 1));
+    if (_global->nCMSSWSteps != 0) {
+      double msPerEvt(toMS(_global->timers.back()) / _global->nCMSSWSteps);
       std::cout << " Other CMSSW  "
                 << std::fixed << std::setprecision(3) << msPerEvt << " ms/evt"
                 << std::endl;
@@ -439,6 +881,32 @@ PandaProducer::endJob()
     std::cout << std::endl << " Total  "
               << std::fixed << std::setprecision(3) << total << " ms/evt"
               << std::endl;
+
+    if (_global->latency) {
+      std::cout << std::endl << "[PandaProducer::endJob] Latency summary" << std::endl;
+      _global->latency->print(std::cout);
+    }
+  }
+
+  if (!_global->perfCounts.empty()) {
+    std::cout << "[PandaProducer::endJob] Hardware counters of fill and setRefs (" << _global->nSelectedEvents << " events)" << std::endl;
+    PerfCounters::print(std::cout, _global->timerNames, _global->perfCounts, _global->nSelectedEvents);
+  }
+
+  if (!_global->allocCounts.empty() && _global->nSelectedEvents != 0) {
+    double nEvents(_global->nSelectedEvents);
+
+    std::cout << "[PandaProducer::endJob] Heap allocations in fill and setRefs (" << _global->nSelectedEvents << " events)" << std::endl;
+    std::cout << std::setw(28) << std::left << " (per event)"
+              << std::setw(14) << std::right << "allocs" << std::setw(14) << "frees" << std::setw(14) << "kB" << std::endl;
+    for (unsigned iF(0); iF != _global->allocCounts.size(); ++iF) {
+      auto& counts(_global->allocCounts[iF]);
+      std::cout << " " << std::setw(27) << std::left << _global->timerNames[iF] << std::right << std::fixed << std::setprecision(1)
+                << std::setw(14) << counts.nAlloc / nEvents
+                << std::setw(14) << counts.nFree / nEvents
+                << std::setw(14) << counts.bytes / nEvents / 1024.
+                << std::endl;
+    }
   }
 }
 
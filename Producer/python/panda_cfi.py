@@ -8,6 +8,37 @@ panda = cms.EDAnalyzer('PandaProducer',
     useTrigger = cms.untracked.bool(True),
     SelectEvents = cms.untracked.vstring(),
     printLevel = cms.untracked.uint32(0),
+    # run independent fillers of one event concurrently (see FillerScheduler)
+    concurrentFillers = cms.untracked.bool(False),
+    # number of event buffers for writing the events tree from a separate thread (0 -> synchronous writing)
+    asyncWriteBuffers = cms.untracked.uint32(0),
+    # count cycles, instructions, and cache and branch misses per filler (Linux perf_event; see PerfCounters)
+    perfCounters = cms.untracked.bool(False),
+    # count heap allocations per filler; requires LD_PRELOAD of libPandaProdAllocationHook.so (see AllocationHook.h)
+    allocationTracking = cms.untracked.bool(False),
+    # record events whose total time or time in any filler exceeds the threshold (ms; 0 -> no check) in the slowEvents tree
+    slowEvents = cms.untracked.PSet(
+        eventThreshold = cms.untracked.double(0.),
+        fillerThreshold = cms.untracked.double(0.)
+    ),
+    # trace-event JSON timeline of nEvents events starting from the firstEvent-th analyzed event (empty fileName -> no trace)
+    trace = cms.untracked.PSet(
+        fileName = cms.untracked.string(''),
+        firstEvent = cms.untracked.uint32(0),
+        nEvents = cms.untracked.uint32(100)
+    ),
+    # output compression and buffering (see CompressionPolicy); empty values keep the ROOT defaults
+    compression = cms.untracked.PSet(
+        algorithm = cms.untracked.string(''),
+        level = cms.untracked.int32(1),
+        basketSize = cms.untracked.int32(0),
+        autoFlush = cms.untracked.int64(0),
+        report = cms.untracked.bool(False),
+        # per-branch-group overrides, e.g.
+        # hot = cms.untracked.PSet(algorithm = cms.untracked.string('lz4'), level = cms.untracked.int32(4), branches = cms.untracked.vstring('chsAK4Jets', 'pfMet')),
+        # bulky = cms.untracked.PSet(algorithm = cms.untracked.string('lzma'), level = cms.untracked.int32(6), branches = cms.untracked.vstring('pfCandidates', 'genParticles'))
+        groups = cms.untracked.PSet()
+    ),
     fillers = cms.untracked.PSet(
         common = cms.untracked.PSet(
             genEventInfo = cms.untracked.string('generator'),
@@ -0,0 +1,119 @@
+#include "../interface/AsyncEventWriter.h"
+
+#include "FWCore/Utilities/interface/Exception.h"
+
+AsyncEventWriter::AsyncEventWriter(TTree& _tree, panda::utils::BranchList const& _branches, unsigned _nBuffers) :
+  tree_(_tree)
+{
+  if (_nBuffers == 0)
+    throw cms::Exception("Configuration") << "AsyncEventWriter needs at least one buffer";
+
+  treeEvent_.book(tree_, _branches);
+
+  for (unsigned iB(0); iB != _nBuffers; ++iB) {
+    buffers_.emplace_back(new panda::Event);
+    free_.push_back(buffers_.back().get());
+  }
+
+  thread_ = std::thread(&AsyncEventWriter::run_, this);
+}
+
+AsyncEventWriter::~AsyncEventWriter()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  cond_.notify_all();
+
+  // pending events are still written before the thread exits
+  thread_.join();
+}
+
+panda::Event&
+AsyncEventWriter::acquire()
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+
+  // buffer of an event that was abandoned (e.g. by an exception) before submission
+  if (current_)
+    return *current_;
+
+  cond_.wait(lock, [this]() { return !this->free_.empty() || this->exception_; });
+
+  rethrow_();
+
+  current_ = free_.front();
+  free_.pop_front();
+
+  return *current_;
+}
+
+void
+AsyncEventWriter::submit()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    queue_.push_back(current_);
+    current_ = 0;
+  }
+  cond_.notify_all();
+}
+
+void
+AsyncEventWriter::drain()
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  cond_.wait(lock, [this]() { return (this->queue_.empty() && !this->writing_) || this->exception_; });
+
+  rethrow_();
+}
+
+void
+AsyncEventWriter::run_()
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+
+  while (true) {
+    cond_.wait(lock, [this]() { return !this->queue_.empty() || this->stop_; });
+
+    if (queue_.empty()) // stop_ and nothing left to write
+      break;
+
+    auto* event(queue_.front());
+    queue_.pop_front();
+    writing_ = true;
+
+    lock.unlock();
+
+    std::exception_ptr exception;
+    try {
+      // all branches of the tree, including those booked after the construction (e.g. genReweight.genParam)
+      event->setAddress(tree_, {"*"}, false);
+      event->fill(tree_);
+      event->releaseTree(tree_);
+    }
+    catch (...) {
+      exception = std::current_exception();
+    }
+
+    lock.lock();
+
+    writing_ = false;
+    free_.push_back(event);
+    if (exception && !exception_)
+      exception_ = exception;
+
+    cond_.notify_all();
+  }
+}
+
+void
+AsyncEventWriter::rethrow_()
+{
+  if (exception_) {
+    auto exception(exception_);
+    exception_ = std::exception_ptr();
+    std::rethrow_exception(exception);
+  }
+}
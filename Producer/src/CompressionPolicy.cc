@@ -0,0 +1,174 @@
+#include "../interface/CompressionPolicy.h"
+
+#include "FWCore/Utilities/interface/EDMException.h"
+
+#include "Compression.h"
+#include "TBranch.h"
+#include "TROOT.h"
+
+#include <map>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+
+CompressionPolicy::CompressionPolicy(edm::ParameterSet const& _cfg) :
+  fileSettings_(parseSettings_(_cfg, "compression")),
+  basketSize_(_cfg.getUntrackedParameter<int>("basketSize", 0)),
+  autoFlush_(_cfg.getUntrackedParameter<long long>("autoFlush", 0)),
+  implicitMT_(_cfg.existsAs<bool>("implicitMT", false) ? int(_cfg.getUntrackedParameter<bool>("implicitMT")) : -1),
+  report_(_cfg.getUntrackedParameter<bool>("report", false))
+{
+  if (!_cfg.existsAs<edm::ParameterSet>("groups", false))
+    return;
+
+  auto& groupsCfg(_cfg.getUntrackedParameterSet("groups"));
+
+  for (auto& groupName : groupsCfg.getParameterNames()) {
+    auto& groupCfg(groupsCfg.getUntrackedParameterSet(groupName));
+
+    groups_.emplace_back();
+    auto& group(groups_.back());
+    group.name = groupName;
+    group.settings = parseSettings_(groupCfg, "compression.groups." + groupName);
+    group.branches = groupCfg.getUntrackedParameter<std::vector<std::string>>("branches");
+
+    if (group.settings < 0)
+      throw edm::Exception(edm::errors::Configuration, "compression.groups." + groupName + ": algorithm not set");
+  }
+}
+
+void
+CompressionPolicy::configure(TFile& _file) const
+{
+  if (fileSettings_ >= 0)
+    _file.SetCompressionSettings(fileSettings_);
+}
+
+void
+CompressionPolicy::configure(TTree& _tree) const
+{
+  if (basketSize_ > 0)
+    _tree.SetBasketSize("*", basketSize_);
+
+  if (autoFlush_ != 0)
+    _tree.SetAutoFlush(autoFlush_);
+
+  if (implicitMT_ == 1) {
+    if (!ROOT::IsImplicitMTEnabled())
+      std::cerr << "[CompressionPolicy] Implicit MT requested but not enabled in ROOT; baskets will be compressed sequentially." << std::endl;
+
+    _tree.SetImplicitMT(true);
+  }
+  else if (implicitMT_ == 0)
+    _tree.SetImplicitMT(false);
+
+  if (groups_.empty())
+    return;
+
+  for (auto* obj : *_tree.GetListOfBranches()) {
+    auto& branch(static_cast<TBranch&>(*obj));
+    int iG(findGroup_(branch.GetName()));
+    if (iG >= 0)
+      branch.SetCompressionSettings(groups_[iG].settings); // applies recursively to sub-branches
+  }
+}
+
+void
+CompressionPolicy::report(TTree& _tree, std::ostream& _out) const
+{
+  struct Bytes {
+    std::string group{"(default)"};
+    long long total{0};
+    long long zip{0};
+  };
+
+  std::map<std::string, Bytes> objects;
+
+  for (auto* obj : *_tree.GetListOfBranches()) {
+    auto& branch(static_cast<TBranch&>(*obj));
+    std::string name(branch.GetName());
+    std::string objName(name.substr(0, name.find('.')));
+
+    auto& bytes(objects[objName]);
+    int iG(findGroup_(name));
+    if (iG >= 0)
+      bytes.group = groups_[iG].name;
+
+    bytes.total += branch.GetTotBytes("*");
+    bytes.zip += branch.GetZipBytes("*");
+  }
+
+  std::vector<std::pair<std::string, Bytes>> sorted(objects.begin(), objects.end());
+  std::sort(sorted.begin(), sorted.end(), [](std::pair<std::string, Bytes> const& p1, std::pair<std::string, Bytes> const& p2) {
+      return p1.second.zip > p2.second.zip;
+    });
+
+  long long sumTotal(0);
+  long long sumZip(0);
+
+  _out << "[CompressionPolicy] Size of " << _tree.GetName() << " per object (" << _tree.GetEntries() << " entries)" << std::endl;
+  _out << std::setw(28) << std::left << " object" << std::setw(14) << "group"
+       << std::setw(14) << std::right << "total (kB)" << std::setw(14) << "zip (kB)" << std::setw(8) << "ratio" << std::endl;
+
+  for (auto& entry : sorted) {
+    auto& bytes(entry.second);
+    _out << " " << std::setw(27) << std::left << entry.first << std::setw(14) << bytes.group
+         << std::setw(14) << std::right << std::fixed << std::setprecision(1) << bytes.total / 1024.
+         << std::setw(14) << bytes.zip / 1024.
+         << std::setw(8) << std::setprecision(2) << (bytes.zip > 0 ? double(bytes.total) / bytes.zip : 0.)
+         << std::endl;
+
+    sumTotal += bytes.total;
+    sumZip += bytes.zip;
+  }
+
+  _out << " " << std::setw(41) << std::left << "Total"
+       << std::setw(14) << std::right << std::setprecision(1) << sumTotal / 1024.
+       << std::setw(14) << sumZip / 1024.
+       << std::setw(8) << std::setprecision(2) << (sumZip > 0 ? double(sumTotal) / sumZip : 0.)
+       << std::endl;
+}
+
+/*static*/
+int
+CompressionPolicy::parseSettings_(edm::ParameterSet const& _cfg, std::string const& _context)
+{
+  auto algoName(_cfg.getUntrackedParameter<std::string>("algorithm", ""));
+  if (algoName.empty())
+    return -1;
+
+  ROOT::ECompressionAlgorithm algorithm;
+  if (algoName == "zlib")
+    algorithm = ROOT::kZLIB;
+  else if (algoName == "lzma")
+    algorithm = ROOT::kLZMA;
+  else if (algoName == "lz4")
+    algorithm = ROOT::kLZ4;
+  else
+    throw edm::Exception(edm::errors::Configuration, _context + ": unknown compression algorithm " + algoName);
+
+  int level(_cfg.getUntrackedParameter<int>("level", 1));
+  if (level < 0 || level > 9)
+    throw edm::Exception(edm::errors::Configuration, _context + ": compression level must be within [0, 9]");
+
+  return ROOT::CompressionSettings(algorithm, level);
+}
+
+int
+CompressionPolicy::findGroup_(std::string const& _branchName) const
+{
+  std::string objName(_branchName.substr(0, _branchName.find('.')));
+
+  int objMatch(-1);
+
+  for (unsigned iG(0); iG != groups_.size(); ++iG) {
+    for (auto& name : groups_[iG].branches) {
+      if (name == _branchName)
+        return iG;
+      if (name == objName && objMatch < 0)
+        objMatch = iG;
+    }
+  }
+
+  return objMatch;
+}
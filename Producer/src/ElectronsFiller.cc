@@ -80,6 +80,40 @@ ElectronsFiller::branchNames(panda::utils::BranchList& _eventBranches, panda::ut
     _eventBranches.emplace_back("!electrons.triggerMatch");
 }
 
+void
+ElectronsFiller::dependencies(VString& _fillers) const
+{
+  _fillers.push_back("superClusters");
+  _fillers.push_back("pfCandidates");
+  _fillers.push_back("vertices");
+  if (!isRealData_)
+    _fillers.push_back("genParticles");
+  if (useTrigger_)
+    _fillers.push_back("hlt");
+}
+
+void
+ElectronsFiller::bookObjectMaps_()
+{
+  eleEleMap_ = &objectMap_->get<reco::GsfElectron, panda::Electron>();
+  scEleMap_ = &objectMap_->get<reco::SuperCluster, panda::Electron>();
+  pfEleMap_ = &objectMap_->get<reco::Candidate, panda::Electron>("pf");
+  vtxEleMap_ = &objectMap_->get<reco::Vertex, panda::Electron>();
+  genEleMap_ = &objectMap_->get<reco::Candidate, panda::Electron>("gen");
+}
+
+void
+ElectronsFiller::resolveObjectMaps(ObjectMapStore const& _objectMaps)
+{
+  scMap_ = resolveObjectMap_<reco::SuperCluster, panda::SuperCluster>(_objectMaps, "superClusters");
+  pfMap_ = resolveObjectMap_<reco::Candidate, panda::PFCand>(_objectMaps, "pfCandidates");
+  vtxMap_ = resolveObjectMap_<reco::Vertex, panda::RecoVertex>(_objectMaps, "vertices");
+  if (!isRealData_)
+    genMap_ = resolveObjectMap_<reco::Candidate, panda::GenParticle>(_objectMaps, "genParticles");
+  if (useTrigger_)
+    hltNameMap_ = resolveObjectMap_<pat::TriggerObjectStandAlone, VString>(_objectMaps, "hlt");
+}
+
 void
 ElectronsFiller::fill(panda::Event& _outEvent, edm::Event const& _inEvent, edm::EventSetup const& _setup)
 {
@@ -280,14 +314,14 @@ ElectronsFiller::fill(panda::Event& _outEvent, edm::Event const& _inEvent, edm::
   }
 
   // sort the output electrons
-  auto originalIndices(outElectrons.sort(panda::Particle::PtGreater));
+  auto originalIndices(sortByPt(outElectrons));
 
   // make reco <-> panda mapping
-  auto& eleEleMap(objectMap_->get<reco::GsfElectron, panda::Electron>());
-  auto& scEleMap(objectMap_->get<reco::SuperCluster, panda::Electron>());
-  auto& pfEleMap(objectMap_->get<reco::Candidate, panda::Electron>("pf"));
-  auto& vtxEleMap(objectMap_->get<reco::Vertex, panda::Electron>());
-  auto& genEleMap(objectMap_->get<reco::Candidate, panda::Electron>("gen"));
+  auto& eleEleMap(*eleEleMap_);
+  auto& scEleMap(*scEleMap_);
+  auto& pfEleMap(*pfEleMap_);
+  auto& vtxEleMap(*vtxEleMap_);
+  auto& genEleMap(*genEleMap_);
   
   for (unsigned iP(0); iP != outElectrons.size(); ++iP) {
     auto& outElectron(outElectrons[iP]);
@@ -319,15 +353,15 @@ ElectronsFiller::fill(panda::Event& _outEvent, edm::Event const& _inEvent, edm::
 }
 
 void
-ElectronsFiller::setRefs(ObjectMapStore const& _objectMaps)
+ElectronsFiller::setRefs(ObjectMapStore const&)
 {
-  auto& scEleMap(objectMap_->get<reco::SuperCluster, panda::Electron>());
-  auto& pfEleMap(objectMap_->get<reco::Candidate, panda::Electron>("pf"));
-  auto& vtxEleMap(objectMap_->get<reco::Vertex, panda::Electron>());
+  auto& scEleMap(*scEleMap_);
+  auto& pfEleMap(*pfEleMap_);
+  auto& vtxEleMap(*vtxEleMap_);
 
-  auto& scMap(_objectMaps.at("superClusters").get<reco::SuperCluster, panda::SuperCluster>().fwdMap);
-  auto& pfMap(_objectMaps.at("pfCandidates").get<reco::Candidate, panda::PFCand>().fwdMap);
-  auto& vtxMap(_objectMaps.at("vertices").get<reco::Vertex, panda::RecoVertex>().fwdMap);
+  auto& scMap(scMap_->fwdMap);
+  auto& pfMap(pfMap_->fwdMap);
+  auto& vtxMap(vtxMap_->fwdMap);
 
   for (auto& link : scEleMap.bwdMap) { // panda -> edm
     auto& outElectron(*link.first);
@@ -351,9 +385,9 @@ ElectronsFiller::setRefs(ObjectMapStore const& _objectMaps)
   }
 
   if (!isRealData_) {
-    auto& genEleMap(objectMap_->get<reco::Candidate, panda::Electron>("gen"));
+    auto& genEleMap(*genEleMap_);
 
-    auto& genMap(_objectMaps.at("genParticles").get<reco::Candidate, panda::GenParticle>().fwdMap);
+    auto& genMap(genMap_->fwdMap);
 
     for (auto& link : genEleMap.bwdMap) {
       auto& genPtr(link.second);
@@ -366,7 +400,7 @@ ElectronsFiller::setRefs(ObjectMapStore const& _objectMaps)
   }
 
   if (useTrigger_) {
-    auto& nameMap(_objectMaps.at("hlt").get<pat::TriggerObjectStandAlone, VString>().fwdMap);
+    auto& nameMap(hltNameMap_->fwdMap);
 
     std::vector<pat::TriggerObjectStandAlone const*> triggerObjects[panda::Electron::nTriggerObjects];
 
@@ -385,7 +419,7 @@ ElectronsFiller::setRefs(ObjectMapStore const& _objectMaps)
       }
     }
 
-    auto& eleEleMap(objectMap_->get<reco::GsfElectron, panda::Electron>().fwdMap);
+    auto& eleEleMap(eleEleMap_->fwdMap);
 
     for (auto& link : eleEleMap) { // edm -> panda
       auto& inElectron(*link.first);
@@ -5,6 +5,8 @@
 #include "DataFormats/Math/interface/deltaR.h"
 
 #include <functional>
+#include <iterator>
+#include <memory>
 
 FatJetsFiller::FatJetsFiller(std::string const& _name, edm::ParameterSet const& _cfg, edm::ConsumesCollector& _coll) :
   JetsFiller(_name, _cfg, _coll),
@@ -14,7 +16,9 @@ FatJetsFiller::FatJetsFiller(std::string const& _name, edm::ParameterSet const&
   subjetBtagTag_(getParameter_<std::string>(_cfg, "subjetBtag", "")),
   subjetQGLTag_(getParameter_<std::string>(_cfg, "subjetQGL", "")),
   activeArea_(7., 1, 0.01),
-  areaDef_(fastjet::active_area_explicit_ghosts, activeArea_)
+  areaDef_(fastjet::active_area_explicit_ghosts, activeArea_),
+  useAreas_(getParameter_<bool>(_cfg, "substructureAreas", true)),
+  parallelTopTagger_(getParameter_<bool>(_cfg, "parallelTopTagger", false))
 {
   if (_name == "chsAK8Jets")
     outSubjetSelector_ = [](panda::Event& _event)->panda::MicroJetCollection& { return _event.chsAK8Subjets; };
@@ -40,13 +44,17 @@ FatJetsFiller::FatJetsFiller(std::string const& _name, edm::ParameterSet const&
   if (computeSubstructure_ == kLargeRecoil)
     getToken_(categoriesToken_, _cfg, _coll, "recoil");
 
+  if (parallelTopTagger_ && !fastjet::HEPTopTaggerV2::parallel_triplets_supported())
+    throw edm::Exception(edm::errors::Configuration, "FatJetsFiller")
+      << "parallelTopTagger requires a FastJet build with thread safety";
+
   if (computeSubstructure_ != kNever) {
     getToken_(doubleBTagInfoToken_, _cfg, _coll, "doubleBTag");
 
     jetDefCA_ = new fastjet::JetDefinition(fastjet::cambridge_algorithm, R_);
     softdrop_ = new fastjet::contrib::SoftDrop(1., 0.15, R_);
-    ecfnManager_ = new ECFNManager();
-    tau_ = new fastjet::contrib::Njettiness(fastjet::contrib::OnePass_KT_Axes(), fastjet::contrib::NormalizedMeasure(1., R_));
+    ecfCalculator_ = new ECFCalculator({0.5, 1., 2., 4.});
+    tau_ = new HierarchicalNjettiness(fastjet::contrib::NormalizedMeasure(1., R_), 3);
 
     //htt
     bool optimalR=true; bool doHTTQ=false;
@@ -65,6 +73,7 @@ FatJetsFiller::FatJetsFiller(std::string const& _name, edm::ParameterSet const&
                                         maxCandMass,massRatioWidth,
                                         minM23Cut,minM13Cut,
                                         maxM13Cut,rejectMinR);
+    htt_->set_parallel_triplets(parallelTopTagger_);
 
     jetBoostedBtaggingMVACalc_.initialize("BDT", getParameter_<edm::FileInPath>(_cfg, "doubleBTagWeights").fullPath());
   }
@@ -74,7 +83,7 @@ FatJetsFiller::~FatJetsFiller()
 {
   delete jetDefCA_;
   delete softdrop_;
-  delete ecfnManager_;
+  delete ecfCalculator_;
   delete tau_;
   delete htt_;
 }
@@ -115,19 +124,24 @@ FatJetsFiller::fillDetails_(panda::Event& _outEvent, edm::Event const& _inEvent,
   if (doSubstructure)
     doubleBTagInfo = &getProduct_(_inEvent, doubleBTagInfoToken_);
 
-  double betas[] = {0.5, 1., 2., 4.};
-
   auto& outSubjets(outSubjetSelector_(_outEvent));
 
   typedef std::vector<fastjet::PseudoJet> VPseudoJet;
 
-  auto& jetMap(objectMap_->get<reco::Jet, panda::Jet>());
+  auto& jetMap(*jetMap_);
 
   unsigned iJ(0);
+  nConstituents_ = 0;
+
+  // double-b BDT inputs, collected over the jets
+  std::vector<float> doubleBInputs;
+  std::vector<panda::FatJet*> doubleBJets;
 
   for (auto& link : jetMap.bwdMap) { // panda -> edm
     auto& outJet(static_cast<panda::FatJet&>(*link.first));
 
+    nConstituents_ += link.second->numberOfDaughters();
+
     if (dynamic_cast<pat::Jet const*>(link.second.get())) {
       auto& inJet(static_cast<pat::Jet const&>(*link.second));
 
@@ -185,8 +199,12 @@ FatJetsFiller::fillDetails_(panda::Event& _outEvent, edm::Event const& _inEvent,
           vjet.emplace_back(cand.px(), cand.py(), cand.pz(), cand.energy());
         }
 
-        fastjet::ClusterSequenceArea seq(vjet, *jetDefCA_, areaDef_);
-        VPseudoJet alljets(fastjet::sorted_by_pt(seq.inclusive_jets(0.1)));
+        std::unique_ptr<fastjet::ClusterSequence> seq;
+        if (useAreas_)
+          seq.reset(new fastjet::ClusterSequenceArea(vjet, *jetDefCA_, areaDef_));
+        else
+          seq.reset(new fastjet::ClusterSequence(vjet, *jetDefCA_));
+        VPseudoJet alljets(fastjet::sorted_by_pt(seq->inclusive_jets(0.1)));
 
         if (alljets.size() > 0){
           fastjet::PseudoJet& leadingJet(alljets[0]);
@@ -197,21 +215,24 @@ FatJetsFiller::fillDetails_(panda::Event& _outEvent, edm::Event const& _inEvent,
           unsigned nFilter(std::min(100, int(sdconsts.size())));
           VPseudoJet sdconstsFiltered(sdconsts.begin(), sdconsts.begin() + nFilter);
 
-          // calculate ECFs
-          for (unsigned iB(0); iB != 4; ++iB) {
-            calcECFN(betas[iB], sdconstsFiltered, ecfnManager_); // calculate for all Ns and os
-            for (int N : {1, 2, 3, 4}) {
-              for (int order : {1, 2, 3}) {
-                float ecf(ecfnManager_->ecfns[TString::Format("%i_%i", N, order)]);
+          // calculate ECFs for all betas, Ns, and os
+          ecfCalculator_->calculate(sdconstsFiltered);
+          auto& ecfs(ecfCalculator_->results());
+          for (unsigned iB(0); iB != ecfCalculator_->nBetas(); ++iB) {
+            for (int N(1); N <= ecfn::kMaxN; ++N) {
+              for (int order(1); order <= ecfn::kMaxOrder; ++order) {
+                float ecf(ecfs[ecfn::slot(iB, N, order)]);
                 if (!outJet.set_ecf(order, N, iB, ecf))
                   throw std::runtime_error(TString::Format("FatJetsFiller Could not save o=%i, N=%i, iB=%i", order, N, iB).Data());
               } // o loop
             } // N loop
           } // beta loop
 
-          outJet.tau3SD = tau_->getTau(3, sdconsts);
-          outJet.tau2SD = tau_->getTau(2, sdconsts);
-          outJet.tau1SD = tau_->getTau(1, sdconsts);
+          double tausSD[3];
+          tau_->getTaus(sdconsts, tausSD);
+          outJet.tau1SD = tausSD[0];
+          outJet.tau2SD = tausSD[1];
+          outJet.tau3SD = tausSD[2];
 
           // HTT
           fastjet::PseudoJet httJet(htt_->result(leadingJet));
@@ -241,41 +262,41 @@ FatJetsFiller::fillDetails_(panda::Event& _outEvent, edm::Event const& _inEvent,
             minSubjetCSV = -1.;
 
           auto&& vars(dbi.taggingVariables());
-          outJet.double_sub =
-            jetBoostedBtaggingMVACalc_.mvaValue(outJet.m(),
-                                                -1, //j.partonFlavor(); // they're spectator variables
-                                                -1, //j.hadronFlavor(); // 
-                                                outJet.pt(),
-                                                outJet.eta(),
-                                                minSubjetCSV,
-                                                vars.get(reco::btau::z_ratio),
-                                                vars.get(reco::btau::trackSip3dSig_3),
-                                                vars.get(reco::btau::trackSip3dSig_2),
-                                                vars.get(reco::btau::trackSip3dSig_1),
-                                                vars.get(reco::btau::trackSip3dSig_0),
-                                                vars.get(reco::btau::tau2_trackSip3dSig_0),
-                                                vars.get(reco::btau::tau1_trackSip3dSig_0),
-                                                vars.get(reco::btau::tau2_trackSip3dSig_1),
-                                                vars.get(reco::btau::tau1_trackSip3dSig_1),
-                                                vars.get(reco::btau::trackSip2dSigAboveCharm),
-                                                vars.get(reco::btau::trackSip2dSigAboveBottom_0),
-                                                vars.get(reco::btau::trackSip2dSigAboveBottom_1),
-                                                vars.get(reco::btau::tau1_trackEtaRel_0),
-                                                vars.get(reco::btau::tau1_trackEtaRel_1),
-                                                vars.get(reco::btau::tau1_trackEtaRel_2),
-                                                vars.get(reco::btau::tau2_trackEtaRel_0),
-                                                vars.get(reco::btau::tau2_trackEtaRel_1),
-                                                vars.get(reco::btau::tau2_trackEtaRel_2),
-                                                vars.get(reco::btau::tau1_vertexMass),
-                                                vars.get(reco::btau::tau1_vertexEnergyRatio),
-                                                vars.get(reco::btau::tau1_vertexDeltaR),
-                                                vars.get(reco::btau::tau1_flightDistance2dSig),
-                                                vars.get(reco::btau::tau2_vertexMass),
-                                                vars.get(reco::btau::tau2_vertexEnergyRatio),
-                                                vars.get(reco::btau::tau2_flightDistance2dSig),
-                                                vars.get(reco::btau::jetNTracks),
-                                                vars.get(reco::btau::jetNSecondaryVertices),
-                                                false);
+          // inputs in the order of BoostedBtaggingMVACalculator::variableNames
+          float const inputs[] = {
+            float(minSubjetCSV),
+            vars.get(reco::btau::z_ratio),
+            vars.get(reco::btau::trackSip3dSig_3),
+            vars.get(reco::btau::trackSip3dSig_2),
+            vars.get(reco::btau::trackSip3dSig_1),
+            vars.get(reco::btau::trackSip3dSig_0),
+            vars.get(reco::btau::tau2_trackSip3dSig_0),
+            vars.get(reco::btau::tau1_trackSip3dSig_0),
+            vars.get(reco::btau::tau2_trackSip3dSig_1),
+            vars.get(reco::btau::tau1_trackSip3dSig_1),
+            vars.get(reco::btau::trackSip2dSigAboveCharm),
+            vars.get(reco::btau::trackSip2dSigAboveBottom_0),
+            vars.get(reco::btau::trackSip2dSigAboveBottom_1),
+            vars.get(reco::btau::tau1_trackEtaRel_0),
+            vars.get(reco::btau::tau1_trackEtaRel_1),
+            vars.get(reco::btau::tau1_trackEtaRel_2),
+            vars.get(reco::btau::tau2_trackEtaRel_0),
+            vars.get(reco::btau::tau2_trackEtaRel_1),
+            vars.get(reco::btau::tau2_trackEtaRel_2),
+            vars.get(reco::btau::tau1_vertexMass),
+            vars.get(reco::btau::tau1_vertexEnergyRatio),
+            vars.get(reco::btau::tau1_vertexDeltaR),
+            vars.get(reco::btau::tau1_flightDistance2dSig),
+            vars.get(reco::btau::tau2_vertexMass),
+            vars.get(reco::btau::tau2_vertexEnergyRatio),
+            vars.get(reco::btau::tau2_flightDistance2dSig),
+            vars.get(reco::btau::jetNTracks),
+            vars.get(reco::btau::jetNSecondaryVertices)
+          };
+          static_assert(sizeof(inputs) / sizeof(float) == panda::BoostedBtaggingMVACalculator::kNVariables, "double-b inputs");
+
+          doubleBInputs.insert(doubleBInputs.end(), std::begin(inputs), std::end(inputs));
+          doubleBJets.push_back(&outJet);
 
           break;
         }
@@ -284,6 +305,14 @@ FatJetsFiller::fillDetails_(panda::Event& _outEvent, edm::Event const& _inEvent,
 
     ++iJ;
   }
+
+  // evaluate the double-b BDT for all jets at once
+  if (!doubleBJets.empty()) {
+    std::vector<float> doubleB(doubleBJets.size());
+    jetBoostedBtaggingMVACalc_.mvaValues(doubleBInputs.data(), doubleBJets.size(), doubleB.data());
+    for (unsigned iDB(0); iDB != doubleBJets.size(); ++iDB)
+      doubleBJets[iDB]->double_sub = doubleB[iDB];
+  }
 }
 
 DEFINE_TREEFILLER(FatJetsFiller);
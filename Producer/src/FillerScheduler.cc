@@ -0,0 +1,198 @@
+#include "../interface/FillerScheduler.h"
+
+#include <set>
+#include <map>
+#include <algorithm>
+
+namespace {
+
+  //! Resources touched by one node
+  struct Access {
+    std::set<std::string> reads{};
+    std::set<std::string> writes{};
+  };
+
+  bool
+  intersects(std::set<std::string> const& _s1, std::set<std::string> const& _s2)
+  {
+    if (_s1.empty() || _s2.empty())
+      return false;
+
+    if (_s1.count("*") != 0 || _s2.count("*") != 0)
+      return true;
+
+    for (auto& r : _s1) {
+      if (_s2.count(r) != 0)
+        return true;
+    }
+
+    return false;
+  }
+
+  bool
+  conflicts(Access const& _earlier, Access const& _later)
+  {
+    return intersects(_earlier.writes, _later.writes) ||
+      intersects(_earlier.writes, _later.reads) ||
+      intersects(_earlier.reads, _later.writes);
+  }
+
+}
+
+FillerScheduler::FillerScheduler(std::vector<FillerBase*> const& _fillers, Step const& _fill, Step const& _setRefs) :
+  start_(graph_)
+{
+  // event branches (top-level names) written by each enabled filler
+  std::map<std::string, std::set<std::string>> fillerBranches;
+  std::vector<unsigned> enabled;
+
+  for (unsigned iF(0); iF != _fillers.size(); ++iF) {
+    auto* filler(_fillers[iF]);
+    if (!filler->enabled())
+      continue;
+
+    enabled.push_back(iF);
+
+    panda::utils::BranchList eventBranches;
+    panda::utils::BranchList runBranches;
+    filler->branchNames(eventBranches, runBranches);
+
+    auto& branches(fillerBranches[filler->getName()]);
+    for (auto& bname : eventBranches) {
+      if (bname.isVeto())
+        continue;
+
+      std::string fullName(bname.fullName().Data());
+      branches.insert("branch:" + fullName.substr(0, fullName.find('.')));
+    }
+
+    if (branches.empty())
+      branches.insert("*");
+  }
+
+  // nodes in the reference (sequential) order
+  std::vector<Access> accesses;
+
+  for (unsigned iF : enabled) {
+    auto* filler(_fillers[iF]);
+    auto& name(filler->getName());
+    auto& branches(fillerBranches[name]);
+
+    Access fillAccess;
+    fillAccess.writes = branches;
+    fillAccess.writes.insert("map:" + name);
+
+    VString resources;
+    filler->sharedResources(resources);
+    for (auto& r : resources)
+      fillAccess.writes.insert("resource:" + r);
+
+    accesses.push_back(fillAccess);
+    nodeNames_.push_back(name + "->fill()");
+    nodes_.emplace_back(new Node(graph_, [this, _fill, iF](tbb::flow::continue_msg const&) {
+          if (this->failed_)
+            return;
+
+          try {
+            _fill(iF);
+          }
+          catch (...) {
+            std::lock_guard<std::mutex> lock(this->exceptionMutex_);
+            if (!this->failed_.exchange(true))
+              this->exception_ = std::current_exception();
+          }
+        }));
+  }
+
+  for (unsigned iF : enabled) {
+    auto* filler(_fillers[iF]);
+    auto& name(filler->getName());
+
+    Access refsAccess;
+    refsAccess.writes = fillerBranches[name];
+
+    VString extraBranches;
+    filler->refBranches(extraBranches);
+    for (auto& b : extraBranches)
+      refsAccess.writes.insert("branch:" + b);
+
+    refsAccess.reads.insert("map:" + name);
+
+    VString dependencies;
+    filler->dependencies(dependencies);
+    for (auto& dep : dependencies) {
+      refsAccess.reads.insert("map:" + dep);
+      auto bItr(fillerBranches.find(dep));
+      if (bItr != fillerBranches.end())
+        refsAccess.reads.insert(bItr->second.begin(), bItr->second.end());
+    }
+
+    accesses.push_back(refsAccess);
+    nodeNames_.push_back(name + "->setRefs()");
+    nodes_.emplace_back(new Node(graph_, [this, _setRefs, iF](tbb::flow::continue_msg const&) {
+          if (this->failed_)
+            return;
+
+          try {
+            _setRefs(iF);
+          }
+          catch (...) {
+            std::lock_guard<std::mutex> lock(this->exceptionMutex_);
+            if (!this->failed_.exchange(true))
+              this->exception_ = std::current_exception();
+          }
+        }));
+  }
+
+  // Connect conflicting pairs, skipping edges already implied by transitivity.
+  // Predecessors of node iN are scanned backwards, so that the closest conflicting nodes are connected first.
+  std::vector<std::vector<bool>> ancestors(nodes_.size(), std::vector<bool>(nodes_.size(), false));
+
+  for (unsigned iN(0); iN != nodes_.size(); ++iN) {
+    for (unsigned iP(iN); iP-- != 0;) {
+      if (ancestors[iN][iP] || !conflicts(accesses[iP], accesses[iN]))
+        continue;
+
+      tbb::flow::make_edge(*nodes_[iP], *nodes_[iN]);
+      edges_.emplace_back(iP, iN);
+
+      ancestors[iN][iP] = true;
+      for (unsigned iA(0); iA != iP; ++iA) {
+        if (ancestors[iP][iA])
+          ancestors[iN][iA] = true;
+      }
+    }
+
+    if (std::find(ancestors[iN].begin(), ancestors[iN].end(), true) == ancestors[iN].end())
+      tbb::flow::make_edge(start_, *nodes_[iN]);
+  }
+}
+
+void
+FillerScheduler::run()
+{
+  failed_ = false;
+  exception_ = std::exception_ptr();
+
+  start_.try_put(tbb::flow::continue_msg());
+  graph_.wait_for_all();
+
+  if (exception_)
+    std::rethrow_exception(exception_);
+}
+
+void
+FillerScheduler::print(std::ostream& _out) const
+{
+  std::vector<bool> hasPredecessor(nodes_.size(), false);
+  for (auto& edge : edges_)
+    hasPredecessor[edge.second] = true;
+
+  for (unsigned iN(0); iN != nodes_.size(); ++iN) {
+    if (!hasPredecessor[iN])
+      _out << " (start) -> " << nodeNames_[iN] << std::endl;
+  }
+
+  for (auto& edge : edges_)
+    _out << " " << nodeNames_[edge.first] << " -> " << nodeNames_[edge.second] << std::endl;
+}
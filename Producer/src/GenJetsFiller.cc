@@ -23,6 +23,12 @@ GenJetsFiller::branchNames(panda::utils::BranchList& _eventBranches, panda::util
   _eventBranches.emplace_back(getName());
 }
 
+void
+GenJetsFiller::bookObjectMaps_()
+{
+  genJetMap_ = &objectMap_->get<reco::GenJet, panda::GenJet>();
+}
+
 void
 GenJetsFiller::fill(panda::Event& _outEvent, edm::Event const& _inEvent, edm::EventSetup const&)
 {
@@ -51,10 +57,10 @@ GenJetsFiller::fill(panda::Event& _outEvent, edm::Event const& _inEvent, edm::Ev
   }
 
   // sort the output electrons
-  auto originalIndices(outJets.sort(panda::Particle::PtGreater));
+  auto originalIndices(sortByPt(outJets));
 
   // make reco <-> panda mapping
-  auto& objectMap(objectMap_->get<reco::GenJet, panda::GenJet>());
+  auto& objectMap(*genJetMap_);
   
   for (unsigned iP(0); iP != outJets.size(); ++iP) {
     auto& outJet(outJets[iP]);
@@ -196,12 +196,19 @@ GenParticlesFiller::branchNames(panda::utils::BranchList& _eventBranches, panda:
   _eventBranches.emplace_back("genParticles");
 }
 
+void
+GenParticlesFiller::bookObjectMaps_()
+{
+  genParticleMap_ = &objectMap_->get<reco::Candidate, panda::GenParticle>();
+}
+
 void
 GenParticlesFiller::fill(panda::Event& _outEvent, edm::Event const& _inEvent, edm::EventSetup const&)
 {
   auto& inParticles(getProduct_(_inEvent, genParticlesToken_));
   // this is miniaod-specific - modify if we need to run on AOD for some reason
   auto& inFinalStates(getProduct_(_inEvent, finalStateParticlesToken_)); 
+  nParticles_ = inParticles.size() + inFinalStates.size();
 
   std::map<reco::CandidatePtr, PNodeWithPtr*> nodeMap;
   std::vector<PNodeWithPtr*> rootNodes;
@@ -222,7 +229,7 @@ GenParticlesFiller::fill(panda::Event& _outEvent, edm::Event const& _inEvent, ed
   auto& outParticles(_outEvent.genParticles);
   outParticles.reserve(inParticles.size() + inFinalStates.size());
   
-  auto& objectMap(objectMap_->get<reco::Candidate, panda::GenParticle>());
+  auto& objectMap(*genParticleMap_);
 
   for (auto* rootNode : rootNodes) {
     if (furtherPrune_)
@@ -92,6 +92,13 @@ HLTFiller::fillBeginRun(panda::Run& _outRun, edm::Run const& _inRun, edm::EventS
   hltTree_->Fill();
 }
 
+void
+HLTFiller::bookObjectMaps_()
+{
+  objMap_ = &objectMap_->get<pat::TriggerObjectStandAlone, panda::HLTObject>();
+  nameMap_ = &objectMap_->get<pat::TriggerObjectStandAlone, VString>();
+}
+
 void
 HLTFiller::fill(panda::Event& _outEvent, edm::Event const& _inEvent, edm::EventSetup const& _setup)
 {
@@ -106,9 +113,9 @@ HLTFiller::fill(panda::Event& _outEvent, edm::Event const& _inEvent, edm::EventS
       outHLT.set(iF);
   }
 
-  auto& objMap(objectMap_->get<pat::TriggerObjectStandAlone, panda::HLTObject>());
+  auto& objMap(*objMap_);
   // This is used in trigger object matching
-  auto& nameMap(objectMap_->get<pat::TriggerObjectStandAlone, VString>());
+  auto& nameMap(*nameMap_);
 
   // Resize first so that the pointers don't become in the loop
   filterNames_.resize(inTriggerObjects.size());
@@ -90,10 +90,44 @@ JetsFiller::branchNames(panda::utils::BranchList& _eventBranches, panda::utils::
     _eventBranches.emplace_back("!" + getName() + ".constituents_");
 }
 
+void
+JetsFiller::dependencies(VString& _fillers) const
+{
+  if (fillConstituents_)
+    _fillers.push_back("pfCandidates");
+  if (!isRealData_ && !outGenJets_.empty())
+    _fillers.push_back(outGenJets_);
+}
+
+void
+JetsFiller::sharedResources(VString& _resources) const
+{
+  // JER smearing draws from the stream random number engine
+  if (!isRealData_ && !jerName_.empty())
+    _resources.push_back("RandomNumberGenerator");
+}
+
+void
+JetsFiller::bookObjectMaps_()
+{
+  jetMap_ = &objectMap_->get<reco::Jet, panda::Jet>();
+  genJetMap_ = &objectMap_->get<reco::GenJet, panda::Jet>();
+}
+
+void
+JetsFiller::resolveObjectMaps(ObjectMapStore const& _objectMaps)
+{
+  if (fillConstituents_)
+    pfMap_ = resolveObjectMap_<reco::Candidate, panda::PFCand>(_objectMaps, "pfCandidates", constituentsLabel_);
+  if (!isRealData_ && !outGenJets_.empty())
+    genMap_ = resolveObjectMap_<reco::GenJet, panda::GenJet>(_objectMaps, outGenJets_);
+}
+
 void
 JetsFiller::fill(panda::Event& _outEvent, edm::Event const& _inEvent, edm::EventSetup const& _setup)
 {
   auto& inJets(getProduct_(_inEvent, jetsToken_));
+  nJets_ = inJets.size();
 
   panda::JetCollection& outJets(outputSelector_(_outEvent));
 
@@ -255,8 +289,8 @@ JetsFiller::fill(panda::Event& _outEvent, edm::Event const& _inEvent, edm::Event
 
   // export panda <-> reco mapping
 
-  auto& objectMap(objectMap_->get<reco::Jet, panda::Jet>());
-  auto& genJetMap(objectMap_->get<reco::GenJet, panda::Jet>());
+  auto& objectMap(*jetMap_);
+  auto& genJetMap(*genJetMap_);
 
   for (unsigned iP(0); iP != outJets.size(); ++iP) {
     auto& outJet(outJets[iP]);
@@ -276,12 +310,12 @@ JetsFiller::fill(panda::Event& _outEvent, edm::Event const& _inEvent, edm::Event
 }
 
 void
-JetsFiller::setRefs(ObjectMapStore const& _objectMaps)
+JetsFiller::setRefs(ObjectMapStore const&)
 {
   if (fillConstituents_) {
-    auto& jetMap(objectMap_->get<reco::Jet, panda::Jet>());
+    auto& jetMap(*jetMap_);
 
-    auto& pfMap(_objectMaps.at("pfCandidates").get<reco::Candidate, panda::PFCand>(constituentsLabel_).fwdMap);
+    auto& pfMap(pfMap_->fwdMap);
 
     for (auto& link : jetMap.fwdMap) { // edm -> panda
       auto& inJet(*link.first);
@@ -324,9 +358,9 @@ JetsFiller::setRefs(ObjectMapStore const& _objectMaps)
   }
 
   if (!isRealData_ && !outGenJets_.empty()) {
-    auto& genJetMap(objectMap_->get<reco::GenJet, panda::Jet>().fwdMap);
+    auto& genJetMap(genJetMap_->fwdMap);
 
-    auto& genMap(_objectMaps.at(outGenJets_).get<reco::GenJet, panda::GenJet>().fwdMap);
+    auto& genMap(genMap_->fwdMap);
 
     for (auto& link : genJetMap) {
       auto& genPtr(link.first);
@@ -0,0 +1,102 @@
+#include "../interface/LatencyHistograms.h"
+
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include "TDirectory.h"
+
+#include <iomanip>
+#include <cmath>
+#include <algorithm>
+
+constexpr double LatencyHistograms::kMinMs;
+constexpr double LatencyHistograms::kMaxMs;
+
+/*static*/
+char const*
+LatencyHistograms::stepName(Step _step)
+{
+  switch (_step) {
+  case kFillAll:
+    return "fillAll";
+  case kFill:
+    return "fill";
+  case kSetRefs:
+    return "setRefs";
+  default:
+    return "";
+  }
+}
+
+LatencyHistograms::LatencyHistograms(std::vector<std::string> const& _fillerNames, TDirectory* _dir/* = 0*/) :
+  names_(_fillerNames),
+  owned_(_dir == 0)
+{
+  // log10(ms) from -6 to 6
+  double const log10Min(std::log10(kMinMs));
+  unsigned const nBins(std::lround((std::log10(kMaxMs) - log10Min) * 10.));
+  std::vector<double> edges(nBins + 1);
+  for (unsigned iB(0); iB <= nBins; ++iB)
+    edges[iB] = std::pow(10., log10Min + iB * 0.1);
+  // exact edges at the range limits, so that the clamped values in fill() never fall outside
+  edges[0] = kMinMs;
+  edges[nBins] = kMaxMs;
+
+  for (auto& name : names_) {
+    for (unsigned iS(0); iS != nSteps; ++iS) {
+      TString hname(TString::Format("%s_%s", name.c_str(), stepName(Step(iS))));
+      auto* hist(new TH1D(hname, name.c_str() + TString(" ") + stepName(Step(iS)) + ";time (ms)", nBins, edges.data()));
+      hist->SetDirectory(_dir);
+      hists_.push_back(hist);
+    }
+  }
+}
+
+LatencyHistograms::~LatencyHistograms()
+{
+  if (owned_) {
+    for (auto* hist : hists_)
+      delete hist;
+  }
+}
+
+void
+LatencyHistograms::add(LatencyHistograms const& _other)
+{
+  if (_other.names_ != names_)
+    throw cms::Exception("LatencyHistograms") << "Cannot add histograms of different fillers";
+
+  for (unsigned iH(0); iH != hists_.size(); ++iH)
+    hists_[iH]->Add(_other.hists_[iH]);
+}
+
+void
+LatencyHistograms::print(std::ostream& _out) const
+{
+  double probs[3] = {0.5, 0.95, 0.99};
+  double quantiles[3] = {};
+
+  _out << std::setw(28) << std::left << " filler" << std::setw(9) << "step"
+       << std::setw(11) << std::right << "calls" << std::setw(11) << "mean"
+       << std::setw(11) << "p50" << std::setw(11) << "p95" << std::setw(11) << "p99" << "  (ms)" << std::endl;
+
+  for (unsigned iF(0); iF != names_.size(); ++iF) {
+    for (unsigned iS(0); iS != nSteps; ++iS) {
+      auto& hist(*hists_[iF * nSteps + iS]);
+      if (hist.GetEntries() == 0.)
+        continue;
+
+      if (hist.Integral() > 0.)
+        hist.GetQuantiles(3, quantiles, probs);
+      else
+        std::fill(quantiles, quantiles + 3, 0.);
+
+      _out << " " << std::setw(27) << std::left << names_[iF] << std::setw(9) << stepName(Step(iS))
+           << std::setw(11) << std::right << (unsigned long long)(hist.GetEntries())
+           << std::setprecision(3)
+           << std::setw(11) << hist.GetMean();
+      for (double q : quantiles)
+        _out << std::setw(11) << q;
+      _out << std::endl;
+    }
+  }
+}
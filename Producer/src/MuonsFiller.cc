@@ -43,6 +43,37 @@ MuonsFiller::branchNames(panda::utils::BranchList& _eventBranches, panda::utils:
     _eventBranches.emplace_back("!muons.triggerMatch");
 }
 
+void
+MuonsFiller::dependencies(VString& _fillers) const
+{
+  _fillers.push_back("pfCandidates");
+  _fillers.push_back("vertices");
+  if (!isRealData_)
+    _fillers.push_back("genParticles");
+  if (useTrigger_)
+    _fillers.push_back("hlt");
+}
+
+void
+MuonsFiller::bookObjectMaps_()
+{
+  muMuMap_ = &objectMap_->get<reco::Muon, panda::Muon>();
+  pfMuMap_ = &objectMap_->get<reco::Candidate, panda::Muon>("pf");
+  vtxMuMap_ = &objectMap_->get<reco::Vertex, panda::Muon>();
+  genMuMap_ = &objectMap_->get<reco::Candidate, panda::Muon>("gen");
+}
+
+void
+MuonsFiller::resolveObjectMaps(ObjectMapStore const& _objectMaps)
+{
+  pfMap_ = resolveObjectMap_<reco::Candidate, panda::PFCand>(_objectMaps, "pfCandidates");
+  vtxMap_ = resolveObjectMap_<reco::Vertex, panda::RecoVertex>(_objectMaps, "vertices");
+  if (!isRealData_)
+    genMap_ = resolveObjectMap_<reco::Candidate, panda::GenParticle>(_objectMaps, "genParticles");
+  if (useTrigger_)
+    hltNameMap_ = resolveObjectMap_<pat::TriggerObjectStandAlone, VString>(_objectMaps, "hlt");
+}
+
 void
 MuonsFiller::fill(panda::Event& _outEvent, edm::Event const& _inEvent, edm::EventSetup const& _setup)
 {
@@ -162,14 +193,14 @@ MuonsFiller::fill(panda::Event& _outEvent, edm::Event const& _inEvent, edm::Even
     ptrList.push_back(inMuons.ptrAt(iMu));
   }
   
-  auto originalIndices(outMuons.sort(panda::Particle::PtGreater));
+  auto originalIndices(sortByPt(outMuons));
 
   // export panda <-> reco mapping
 
-  auto& muMuMap(objectMap_->get<reco::Muon, panda::Muon>());
-  auto& pfMuMap(objectMap_->get<reco::Candidate, panda::Muon>("pf"));
-  auto& vtxMuMap(objectMap_->get<reco::Vertex, panda::Muon>());
-  auto& genMuMap(objectMap_->get<reco::Candidate, panda::Muon>("gen"));
+  auto& muMuMap(*muMuMap_);
+  auto& pfMuMap(*pfMuMap_);
+  auto& vtxMuMap(*vtxMuMap_);
+  auto& genMuMap(*genMuMap_);
 
   for (unsigned iP(0); iP != outMuons.size(); ++iP) {
     auto& outMuon(outMuons[iP]);
@@ -200,13 +231,13 @@ MuonsFiller::fill(panda::Event& _outEvent, edm::Event const& _inEvent, edm::Even
 }
 
 void
-MuonsFiller::setRefs(ObjectMapStore const& _objectMaps)
+MuonsFiller::setRefs(ObjectMapStore const&)
 {
-  auto& pfMuMap(objectMap_->get<reco::Candidate, panda::Muon>("pf"));
-  auto& vtxMuMap(objectMap_->get<reco::Vertex, panda::Muon>());
+  auto& pfMuMap(*pfMuMap_);
+  auto& vtxMuMap(*vtxMuMap_);
 
-  auto& pfMap(_objectMaps.at("pfCandidates").get<reco::Candidate, panda::PFCand>().fwdMap);
-  auto& vtxMap(_objectMaps.at("vertices").get<reco::Vertex, panda::RecoVertex>().fwdMap);
+  auto& pfMap(pfMap_->fwdMap);
+  auto& vtxMap(vtxMap_->fwdMap);
 
   for (auto& link : pfMuMap.bwdMap) { // panda -> edm
     auto& outMuon(*link.first);
@@ -228,9 +259,9 @@ MuonsFiller::setRefs(ObjectMapStore const& _objectMaps)
   }
 
   if (!isRealData_) {
-    auto& genMuMap(objectMap_->get<reco::Candidate, panda::Muon>("gen"));
+    auto& genMuMap(*genMuMap_);
 
-    auto& genMap(_objectMaps.at("genParticles").get<reco::Candidate, panda::GenParticle>().fwdMap);
+    auto& genMap(genMap_->fwdMap);
 
     for (auto& link : genMuMap.bwdMap) {
       auto& genPtr(link.second);
@@ -243,7 +274,7 @@ MuonsFiller::setRefs(ObjectMapStore const& _objectMaps)
   }
 
   if (useTrigger_) {
-    auto& nameMap(_objectMaps.at("hlt").get<pat::TriggerObjectStandAlone, VString>().fwdMap);
+    auto& nameMap(hltNameMap_->fwdMap);
 
     std::vector<pat::TriggerObjectStandAlone const*> triggerObjects[panda::Muon::nTriggerObjects];
 
@@ -262,7 +293,7 @@ MuonsFiller::setRefs(ObjectMapStore const& _objectMaps)
       }
     }
 
-    auto& muMuMap(objectMap_->get<reco::Muon, panda::Muon>().fwdMap);
+    auto& muMuMap(muMuMap_->fwdMap);
 
     for (auto& link : muMuMap) { // edm -> panda
       auto& inMuon(*link.first);
@@ -0,0 +1,421 @@
+#include "../interface/OutputMerger.h"
+
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include "TFile.h"
+#include "TTree.h"
+#include "TLeaf.h"
+#include "TKey.h"
+#include "TClass.h"
+#include "TH1.h"
+#include "TAxis.h"
+#include "TSystem.h"
+
+#include <map>
+#include <set>
+#include <utility>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+  //! Output buffer for one lumiSummary leaf
+  struct LeafBuffer {
+    LeafBuffer(TLeaf const&);
+
+    void set(int idx, double value);
+
+    std::string branchName;
+    std::string leafList;
+    char type;
+    int len;
+    std::vector<Long64_t> buffer; // 8-byte slots, large enough for any basic type
+  };
+
+  LeafBuffer::LeafBuffer(TLeaf const& _leaf) :
+    branchName(_leaf.GetBranch()->GetName()),
+    len(_leaf.GetLen()),
+    buffer(_leaf.GetLen(), 0)
+  {
+    TString typeName(_leaf.GetTypeName());
+    if (typeName == "UInt_t")
+      type = 'i';
+    else if (typeName == "Int_t")
+      type = 'I';
+    else if (typeName == "ULong64_t")
+      type = 'l';
+    else if (typeName == "Long64_t")
+      type = 'L';
+    else if (typeName == "Float_t")
+      type = 'F';
+    else if (typeName == "Double_t")
+      type = 'D';
+    else
+      throw cms::Exception("OutputMerger") << "Cannot merge lumiSummary leaf " << _leaf.GetName() << " of type " << typeName;
+
+    if (len > 1)
+      leafList = TString::Format("%s[%d]/%c", _leaf.GetName(), len, type).Data();
+    else
+      leafList = TString::Format("%s/%c", _leaf.GetName(), type).Data();
+  }
+
+  void
+  LeafBuffer::set(int _idx, double _value)
+  {
+    switch (type) {
+    case 'i':
+      reinterpret_cast<UInt_t*>(buffer.data())[_idx] = _value;
+      break;
+    case 'I':
+      reinterpret_cast<Int_t*>(buffer.data())[_idx] = _value;
+      break;
+    case 'l':
+      reinterpret_cast<ULong64_t*>(buffer.data())[_idx] = _value;
+      break;
+    case 'L':
+      reinterpret_cast<Long64_t*>(buffer.data())[_idx] = _value;
+      break;
+    case 'F':
+      reinterpret_cast<Float_t*>(buffer.data())[_idx] = _value;
+      break;
+    case 'D':
+      reinterpret_cast<Double_t*>(buffer.data())[_idx] = _value;
+      break;
+    }
+  }
+
+  //! Leaf names, types and lengths of a tree, used to check that segments can be fast-copied together
+  std::string
+  treeStructure(TTree& _tree)
+  {
+    std::string structure;
+    for (auto* obj : *_tree.GetListOfLeaves()) {
+      auto& leaf(static_cast<TLeaf&>(*obj));
+      structure += TString::Format("%s/%s[%d];", leaf.GetBranch()->GetName(), leaf.GetTypeName(), leaf.GetLenStatic()).Data();
+    }
+    return structure;
+  }
+
+  bool
+  allBinsLabeled(TAxis const& _axis)
+  {
+    if (!_axis.GetLabels())
+      return false;
+
+    for (int iX(1); iX <= _axis.GetNbins(); ++iX) {
+      if (std::strlen(_axis.GetBinLabel(iX)) == 0)
+        return false;
+    }
+    return true;
+  }
+
+  //! Same binning and labels
+  bool
+  sameBinning(TH1 const& _h1, TH1 const& _h2)
+  {
+    if (_h1.GetDimension() != _h2.GetDimension() || _h1.GetNcells() != _h2.GetNcells())
+      return false;
+
+    TAxis const* axes1[] = {_h1.GetXaxis(), _h1.GetYaxis(), _h1.GetZaxis()};
+    TAxis const* axes2[] = {_h2.GetXaxis(), _h2.GetYaxis(), _h2.GetZaxis()};
+    for (int iA(0); iA != _h1.GetDimension(); ++iA) {
+      auto& axis1(*axes1[iA]);
+      auto& axis2(*axes2[iA]);
+      if (axis1.GetNbins() != axis2.GetNbins() || axis1.GetXmin() != axis2.GetXmin() || axis1.GetXmax() != axis2.GetXmax())
+        return false;
+
+      for (int iX(1); iX <= axis1.GetNbins(); ++iX) {
+        if (std::strcmp(axis1.GetBinLabel(iX), axis2.GetBinLabel(iX)) != 0)
+          return false;
+      }
+    }
+    return true;
+  }
+
+  //! Add a 1D histogram with labeled bins to another by matching the labels
+  /*!
+   * Segments can have a different number of labeled bins, e.g. hSumW, which gets a bin per signal weight
+   * learned by the stream. The target is rebinned to the union of the labels, in order of appearance.
+   */
+  void
+  addByLabels(TH1& _target, TH1 const& _source)
+  {
+    std::vector<std::string> labels;
+    std::map<std::string, std::pair<double, double>> contents; // label -> (sumw, sumw2)
+
+    TH1 const* hists[] = {&_target, &_source};
+    for (auto* hist : hists) {
+      for (int iX(1); iX <= hist->GetNbinsX(); ++iX) {
+        std::string label(hist->GetXaxis()->GetBinLabel(iX));
+        auto cItr(contents.find(label));
+        if (cItr == contents.end()) {
+          labels.push_back(label);
+          cItr = contents.emplace(label, std::pair<double, double>(0., 0.)).first;
+        }
+        cItr->second.first += hist->GetBinContent(iX);
+        cItr->second.second += std::pow(hist->GetBinError(iX), 2.);
+      }
+    }
+
+    double entries(_target.GetEntries() + _source.GetEntries());
+
+    _target.Reset();
+    _target.SetBins(labels.size(), 0., labels.size());
+    for (unsigned iL(0); iL != labels.size(); ++iL) {
+      auto& content(contents[labels[iL]]);
+      _target.GetXaxis()->SetBinLabel(iL + 1, labels[iL].c_str());
+      _target.SetBinContent(iL + 1, content.first);
+      _target.SetBinError(iL + 1, std::sqrt(content.second));
+    }
+    _target.SetEntries(entries);
+  }
+
+}
+
+OutputMerger::OutputMerger(std::string const& _outputName) :
+  outputName_(_outputName)
+{
+}
+
+void
+OutputMerger::merge()
+{
+  if (segments_.size() == 0)
+    return;
+
+  if (segments_.size() == 1) {
+    if (gSystem->Rename(segments_[0].c_str(), outputName_.c_str()) != 0)
+      throw cms::Exception("OutputMerger") << "Failed to rename " << segments_[0] << " to " << outputName_;
+    return;
+  }
+
+  std::vector<TFile*> inputs;
+  for (auto& name : segments_) {
+    auto* source(TFile::Open(name.c_str()));
+    if (!source || source->IsZombie())
+      throw cms::Exception("OutputMerger") << "Failed to open output segment " << name;
+    inputs.push_back(source);
+  }
+
+  auto* output(TFile::Open(outputName_.c_str(), "recreate"));
+  if (!output || output->IsZombie())
+    throw cms::Exception("OutputMerger") << "Failed to open " << outputName_;
+
+  // fast-copied trees keep the compression settings of the segments
+  if (compressionSettings_ >= 0)
+    output->SetCompressionSettings(compressionSettings_);
+
+  for (auto& treeName : concatenated_)
+    concatenate_(*output, inputs, treeName);
+
+  mergeLumiSummary_(*output, inputs);
+
+  std::set<std::string> done(concatenated_.begin(), concatenated_.end());
+  done.insert("lumiSummary");
+
+  std::vector<TDirectory*> inputDirs(inputs.begin(), inputs.end());
+  mergeDirectory_(*output, inputDirs, done);
+
+  // writes out the histograms
+  output->cd();
+  output->Write();
+  delete output;
+
+  for (auto* source : inputs)
+    delete source;
+
+  for (auto& name : segments_)
+    gSystem->Unlink(name.c_str());
+}
+
+void
+OutputMerger::mergeDirectory_(TDirectory& _output, std::vector<TDirectory*> const& _inputs, std::set<std::string> _done) const
+{
+  std::map<std::string, TH1*> histograms;
+  std::vector<std::string> subdirs;
+
+  for (auto* source : _inputs) {
+    std::set<std::string> seen; // keys can appear with multiple cycles
+    for (auto* obj : *source->GetListOfKeys()) {
+      auto& key(static_cast<TKey&>(*obj));
+      std::string name(key.GetName());
+      if (!seen.insert(name).second)
+        continue;
+
+      auto* cls(TClass::GetClass(key.GetClassName()));
+      if (!cls)
+        continue;
+
+      if (cls->InheritsFrom(TH1::Class())) {
+        auto* hist(static_cast<TH1*>(key.ReadObj()));
+        auto hItr(histograms.find(name));
+        if (hItr == histograms.end()) {
+          hist->SetDirectory(&_output);
+          histograms.emplace(name, hist);
+        }
+        else {
+          auto& target(*hItr->second);
+          if (sameBinning(target, *hist))
+            target.Add(hist);
+          else if (target.GetDimension() == 1 && hist->GetDimension() == 1 && allBinsLabeled(*target.GetXaxis()) && allBinsLabeled(*hist->GetXaxis()))
+            addByLabels(target, *hist);
+          else
+            throw cms::Exception("OutputMerger") << "Histogram " << name << " in " << source->GetName() << " has a binning different from the other segments";
+
+          delete hist;
+        }
+      }
+      else if (cls->InheritsFrom(TTree::Class())) {
+        if (!_done.insert(name).second)
+          continue;
+
+        auto* tree(static_cast<TTree*>(key.ReadObj()));
+
+        TDirectory::TContext context(&_output);
+        auto* clone(tree->CloneTree(-1, "fast"));
+        clone->Write();
+        delete clone;
+      }
+      else if (cls->InheritsFrom(TDirectory::Class())) {
+        if (_done.insert(name).second)
+          subdirs.push_back(name);
+      }
+    }
+  }
+
+  for (auto& name : subdirs) {
+    std::vector<TDirectory*> inputs;
+    for (auto* source : _inputs) {
+      auto* dir(source->GetDirectory(name.c_str()));
+      if (dir)
+        inputs.push_back(dir);
+    }
+
+    mergeDirectory_(*_output.mkdir(name.c_str()), inputs, std::set<std::string>());
+  }
+}
+
+void
+OutputMerger::concatenate_(TFile& _output, std::vector<TFile*> const& _inputs, std::string const& _treeName) const
+{
+  // Segments of streams that wrote no entries are skipped: their structure may lack branches that are
+  // booked at the first encounter (e.g. genReweight.genParam). All other segments must have the same
+  // structure for the fast copy.
+  std::vector<TTree*> trees;
+  TTree* emptyTree(0);
+
+  for (auto* source : _inputs) {
+    auto* tree(static_cast<TTree*>(source->Get(_treeName.c_str())));
+    if (!tree)
+      continue;
+
+    if (tree->GetEntries() == 0) {
+      if (!emptyTree)
+        emptyTree = tree;
+      continue;
+    }
+
+    if (!trees.empty() && treeStructure(*tree) != treeStructure(*trees.front())) {
+      throw cms::Exception("OutputMerger") << "Tree " << _treeName << " in " << source->GetName()
+                                           << " has a structure different from " << trees.front()->GetCurrentFile()->GetName();
+    }
+
+    trees.push_back(tree);
+  }
+
+  if (trees.empty() && emptyTree)
+    trees.push_back(emptyTree);
+
+  TTree* merged(0);
+
+  for (auto* tree : trees) {
+    if (!merged) {
+      TDirectory::TContext context(&_output);
+      merged = tree->CloneTree(-1, "fast");
+    }
+    else {
+      Long64_t nEntries(merged->GetEntries());
+      merged->CopyEntries(tree, -1, "fast");
+      if (merged->GetEntries() != nEntries + tree->GetEntries())
+        throw cms::Exception("OutputMerger") << "Failed to copy " << _treeName << " from " << tree->GetCurrentFile()->GetName();
+    }
+  }
+
+  if (merged) {
+    TDirectory::TContext context(&_output);
+    merged->Write();
+    delete merged;
+  }
+}
+
+void
+OutputMerger::mergeLumiSummary_(TFile& _output, std::vector<TFile*> const& _inputs) const
+{
+  typedef std::pair<unsigned, unsigned> LumiKey;
+
+  // flat list of leaf values per lumi; run and lumi numbers are copied, everything else is summed
+  std::map<LumiKey, std::vector<double>> values;
+  std::vector<LeafBuffer> buffers;
+
+  for (auto* source : _inputs) {
+    auto* tree(static_cast<TTree*>(source->Get("lumiSummary")));
+    if (!tree)
+      continue;
+
+    auto* runLeaf(tree->GetLeaf("runNumber"));
+    auto* lumiLeaf(tree->GetLeaf("lumiNumber"));
+    if (!runLeaf || !lumiLeaf)
+      throw cms::Exception("OutputMerger") << "lumiSummary in " << source->GetName() << " lacks run and lumi numbers";
+
+    auto* leaves(tree->GetListOfLeaves());
+
+    if (buffers.empty()) {
+      for (auto* obj : *leaves)
+        buffers.emplace_back(static_cast<TLeaf&>(*obj));
+    }
+    else if (unsigned(leaves->GetEntries()) != buffers.size())
+      throw cms::Exception("OutputMerger") << "lumiSummary in " << source->GetName() << " has inconsistent leaves";
+
+    for (long long iE(0); iE != tree->GetEntries(); ++iE) {
+      tree->GetEntry(iE);
+
+      auto& sums(values[LumiKey(runLeaf->GetValue(), lumiLeaf->GetValue())]);
+
+      unsigned iV(0);
+      for (auto* obj : *leaves) {
+        auto& leaf(static_cast<TLeaf&>(*obj));
+        bool isKey(&leaf == runLeaf || &leaf == lumiLeaf);
+        for (int iL(0); iL != leaf.GetLen(); ++iL, ++iV) {
+          if (iV == sums.size())
+            sums.push_back(0.);
+
+          if (isKey)
+            sums[iV] = leaf.GetValue(iL);
+          else
+            sums[iV] += leaf.GetValue(iL);
+        }
+      }
+    }
+  }
+
+  if (buffers.empty())
+    return;
+
+  TDirectory::TContext context(&_output);
+
+  auto* merged(new TTree("lumiSummary", ""));
+  for (auto& buffer : buffers)
+    merged->Branch(buffer.branchName.c_str(), buffer.buffer.data(), buffer.leafList.c_str());
+
+  for (auto& lumi : values) {
+    unsigned iV(0);
+    for (auto& buffer : buffers) {
+      for (int iL(0); iL != buffer.len; ++iL, ++iV)
+        buffer.set(iL, lumi.second[iV]);
+    }
+    merged->Fill();
+  }
+
+  merged->Write();
+  delete merged;
+}
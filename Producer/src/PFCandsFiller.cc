@@ -2,10 +2,13 @@
 
 #include "DataFormats/Candidate/interface/Candidate.h"
 #include "DataFormats/PatCandidates/interface/PackedCandidate.h"
+#include "DataFormats/PatCandidates/interface/libminifloat.h"
 #include "DataFormats/TrackReco/interface/TrackBase.h"
 
 #include "PandaProd/Auxiliary/interface/PackedValuesExposer.h"
 
+#include <algorithm>
+
 PFCandsFiller::PFCandsFiller(std::string const& _name, edm::ParameterSet const& _cfg, edm::ConsumesCollector& _coll) :
   FillerBase(_name, _cfg),
   useExistingWeights_(getParameter_<bool>(_cfg, "useExistingWeights", true))
@@ -25,11 +28,38 @@ PFCandsFiller::branchNames(panda::utils::BranchList& _eventBranches, panda::util
   _eventBranches.emplace_back("tracks");
 }
 
+void
+PFCandsFiller::dependencies(VString& _fillers) const
+{
+  _fillers.push_back("vertices");
+}
+
+void
+PFCandsFiller::refBranches(VString& _branches) const
+{
+  // pfRangeMax is set in setRefs
+  _branches.push_back("vertices");
+}
+
+void
+PFCandsFiller::bookObjectMaps_()
+{
+  pfMap_ = &objectMap_->get<reco::Candidate, panda::PFCand>();
+  puppiMap_ = &objectMap_->get<reco::Candidate, panda::PFCand>("puppi");
+}
+
+void
+PFCandsFiller::resolveObjectMaps(ObjectMapStore const& _objectMaps)
+{
+  vtxMap_ = resolveObjectMap_<reco::Vertex, panda::RecoVertex>(_objectMaps, "vertices");
+}
+
 void
 PFCandsFiller::fill(panda::Event& _outEvent, edm::Event const& _inEvent, edm::EventSetup const&)
 {
   edm::Handle<reco::CandidateView> candsHandle;
   auto& inCands(getProduct_(_inEvent, candidatesToken_, &candsHandle));
+  nCandidates_ = inCands.size();
   auto& inVertices(getProduct_(_inEvent, verticesToken_));
 
   // connect inCands and the puppi candidates by references to the base collection
@@ -39,74 +69,67 @@ PFCandsFiller::fill(panda::Event& _outEvent, edm::Event const& _inEvent, edm::Ev
   // In more practical terms:
   //   edm::Ref<View>(viewHandle, iview) maps to a puppi candidate via puppiMap
   //   View::refAt(iview).key() is the index of the PF candidate in the original collection
+  // The puppi candidates are stored in puppiPtrs_ and puppiNoLepPtrs_ at the position of the
+  // matching candidate in inCands.
 
-  std::map<reco::CandidatePtr, reco::Candidate const*> inCandsMap;
-
-  std::map<reco::Candidate const*, reco::CandidatePtr> puppiPtrMap;
+  puppiPtrs_.clear();
+  puppiNoLepPtrs_.clear();
+  pfIndexed_ = false;
 
   if (!puppiMapToken_.second.isUninitialized()) {
-    for (unsigned iC(0); iC != inCands.size(); ++iC) {
-      auto ptrToPF(inCands.ptrAt(iC)); // returns a pointer to the original collection (as opposed to Ref<CandidateView> ref(candsHandle, iC));
-      inCandsMap[ptrToPF] = &inCands.at(iC);
-    }
-
     auto& puppiMap(getProduct_(_inEvent, puppiMapToken_));
     edm::Handle<reco::CandidateView> puppiInputHandle;
-    auto& puppiInput(getProduct_(_inEvent, puppiInputToken_, &puppiInputHandle));
-    for (unsigned iC(0); iC != puppiInput.size(); ++iC) {
-      edm::Ref<reco::CandidateView> inputRef(puppiInputHandle, iC);
-      auto& puppiPtr(puppiMap[inputRef]);
-
-      auto ptrToPF(puppiInput.ptrAt(iC));
-      auto inCandsItr(inCandsMap.find(ptrToPF));
-      if (inCandsItr == inCandsMap.end()) {
-        // You are here because of a misconfiguration or because the input to puppi had some layer(s) of PF candidate cloning.
-        // It may be possible to trace back to the original PF collection through calls to sourceCandidatePtr()
-        // but for now we don't need to implement it.
-        throw std::runtime_error("Cannot find candidate matching a puppi input");
-      }
+    getProduct_(_inEvent, puppiInputToken_, &puppiInputHandle);
 
-      puppiPtrMap[inCandsItr->second] = puppiPtr;
-    }
+    associatePuppi_(candsHandle, puppiMap, puppiInputHandle, puppiPtrs_, "puppi");
   }
 
-  std::map<reco::Candidate const*, reco::CandidatePtr> puppiNoLepPtrMap;
-
   if (!puppiNoLepMapToken_.second.isUninitialized()) {
-    if (inCandsMap.empty()) {
-      for (unsigned iC(0); iC != inCands.size(); ++iC) {
-        auto ptrToPF(inCands.ptrAt(iC)); // returns a pointer to the original collection (as opposed to Ref<CandidateView> ref(candsHandle, iC));
-        inCandsMap[ptrToPF] = &inCands.at(iC);
-      }
-    }
-
     auto& puppiNoLepMap(getProduct_(_inEvent, puppiNoLepMapToken_));
     edm::Handle<reco::CandidateView> puppiNoLepInputHandle;
-    auto& puppiNoLepInput(getProduct_(_inEvent, puppiNoLepInputToken_, &puppiNoLepInputHandle));
-    for (unsigned iC(0); iC != puppiNoLepInput.size(); ++iC) {
-      edm::Ref<reco::CandidateView> inputRef(puppiNoLepInputHandle, iC);
-      auto& puppiNoLepPtr(puppiNoLepMap[inputRef]);
-
-      auto ptrToPF(puppiNoLepInput.ptrAt(iC));
-      auto inCandsItr(inCandsMap.find(ptrToPF));
-      if (inCandsItr == inCandsMap.end()) {
-        // See above
-        throw std::runtime_error("Cannot find candidate matching a puppiNoLep input");
-      }
+    getProduct_(_inEvent, puppiNoLepInputToken_, &puppiNoLepInputHandle);
 
-      puppiNoLepPtrMap[inCandsItr->second] = puppiNoLepPtr;
+    associatePuppi_(candsHandle, puppiNoLepMap, puppiNoLepInputHandle, puppiNoLepPtrs_, "puppiNoLep");
+  }
+
+  // Output is ordered by vertex and then by descending pt. The key (vertex index, pt) is extracted
+  // once per candidate and the candidates are written out in sorted order, so the collection is
+  // never sorted. Packed candidates are keyed by the packed pt, which is copied to the output as is.
+  std::vector<pat::PackedCandidate const*> inPackedList(inCands.size());
+  std::vector<uint64_t> sortKeys(inCands.size());
+
+  for (unsigned iP(0); iP != inCands.size(); ++iP) {
+    auto& inCand(inCands.at(iP));
+
+    auto* inPacked(dynamic_cast<pat::PackedCandidate const*>(&inCand));
+    inPackedList[iP] = inPacked;
+
+    // vertex index compared as unsigned: candidates without a vertex (-1) come last
+    uint64_t vtxKey(0xffff);
+    float pt(0.);
+    if (inPacked) {
+      auto vtxRef(inPacked->vertexRef());
+      if (vtxRef.isNonnull())
+        vtxKey = std::min<uint64_t>(vtxRef.key(), 0xffff);
+      pt = MiniFloatConverter::float16to32(PackedPatCandidateExposer(*inPacked).packedPt());
     }
+    else
+      pt = inCand.pt();
+
+    sortKeys[iP] = (vtxKey << 32) | ~panda::floatKey(pt);
   }
 
-  auto& outCands(_outEvent.pfCandidates);
+  std::vector<unsigned> originalIndices;
+  panda::keySort(sortKeys, originalIndices);
 
-  std::vector<reco::CandidatePtr> ptrList;
+  auto& outCands(_outEvent.pfCandidates);
+  outCands.reserve(inCands.size());
 
-  unsigned iP(-1);
-  for (auto& inCand : inCands) {
-    ++iP;
+  std::vector<reco::CandidatePtr> ptrList(inCands.size());
 
-    auto* inPacked(dynamic_cast<pat::PackedCandidate const*>(&inCand));
+  for (unsigned iP : originalIndices) {
+    auto& inCand(inCands.at(iP));
+    auto* inPacked(inPackedList[iP]);
 
     auto& outCand(outCands.create_back());
 
@@ -138,17 +161,11 @@ PFCandsFiller::fill(panda::Event& _outEvent, edm::Event const& _inEvent, edm::Ev
       double puppiW(-1.);
       double puppiWNoLep(-1.);
 
-      if (!puppiPtrMap.empty()) {
-        auto&& ppItr(puppiPtrMap.find(&inCand));
-        if (ppItr != puppiPtrMap.end() && ppItr->second.isNonnull())
-          puppiW = ppItr->second->pt() / inCand.pt();
-      }
+      if (!puppiPtrs_.empty() && puppiPtrs_[iP].isNonnull())
+        puppiW = puppiPtrs_[iP]->pt() / inCand.pt();
 
-      if (!puppiNoLepPtrMap.empty()) {
-        auto&& ppItr(puppiNoLepPtrMap.find(&inCand));
-        if (ppItr != puppiNoLepPtrMap.end() && ppItr->second.isNonnull())
-          puppiWNoLep = ppItr->second->pt() / inCand.pt();
-      }
+      if (!puppiNoLepPtrs_.empty() && puppiNoLepPtrs_[iP].isNonnull())
+        puppiWNoLep = puppiNoLepPtrs_[iP]->pt() / inCand.pt();
 
       outCand.setPuppiW(puppiW, puppiWNoLep);
     }
@@ -163,24 +180,12 @@ PFCandsFiller::fill(panda::Event& _outEvent, edm::Event const& _inEvent, edm::Ev
       ++ptype;
     }
 
-    ptrList.push_back(inCands.ptrAt(iP));
+    ptrList[iP] = inCands.ptrAt(iP);
   }
 
-  auto ByVertexAndPt([](panda::Element const& e1, panda::Element const& e2)->Bool_t {
-      auto& p1(static_cast<panda::PFCand const&>(e1));
-      auto& p2(static_cast<panda::PFCand const&>(e2));
-      if (p1.vertex.idx() == p2.vertex.idx())
-        return p1.pt() > p2.pt();
-      else
-        return unsigned(p1.vertex.idx()) < unsigned(p2.vertex.idx());
-    });
-
-  // sort the output electrons
-  auto originalIndices(outCands.sort(ByVertexAndPt));
-
   // make reco <-> panda mapping
-  auto& objectMap(objectMap_->get<reco::Candidate, panda::PFCand>());
-  auto& puppiMap(objectMap_->get<reco::Candidate, panda::PFCand>("puppi"));
+  auto& objectMap(*pfMap_);
+  auto& puppiMap(*puppiMap_);
   
   for (unsigned iP(0); iP != outCands.size(); ++iP) {
     auto& outCand(outCands[iP]);
@@ -188,9 +193,8 @@ PFCandsFiller::fill(panda::Event& _outEvent, edm::Event const& _inEvent, edm::Ev
     auto& ptr(ptrList[idx]);
     objectMap.add(ptr, outCand);
 
-    auto&& ppItr(puppiPtrMap.find(ptr.get()));
-    if (ppItr != puppiPtrMap.end() && ppItr->second.isNonnull())
-      puppiMap.add(ppItr->second, outCand);
+    if (!puppiPtrs_.empty() && puppiPtrs_[idx].isNonnull())
+      puppiMap.add(puppiPtrs_[idx], outCand);
 
     // add track information for charged hadrons
     // track order matters; track ref from PFCand are set during Event::getEntry relying on the order
@@ -229,9 +233,115 @@ PFCandsFiller::fill(panda::Event& _outEvent, edm::Event const& _inEvent, edm::Ev
 }
 
 void
-PFCandsFiller::setRefs(ObjectMapStore const& _objectMaps)
+PFCandsFiller::associatePuppi_(edm::Handle<reco::CandidateView> const& _candsHandle, CandidatePtrMap const& _puppiMap, edm::Handle<reco::CandidateView> const& _inputHandle, std::vector<reco::CandidatePtr>& _puppiPtrs, char const* _inputName)
+{
+  auto& input(*_inputHandle);
+
+  _puppiPtrs.assign(_candsHandle->size(), reco::CandidatePtr());
+
+  // puppi run directly on the PF candidates: positions in the two views coincide
+  bool sameProduct(_inputHandle.id() == _candsHandle.id());
+
+  if (!sameProduct && !pfIndexed_) {
+    indexPFCandidates_(*_candsHandle);
+    pfIndexed_ = true;
+  }
+
+  for (unsigned iC(0); iC != input.size(); ++iC) {
+    int iPF(iC);
+    if (!sameProduct) {
+      auto ptrToPF(input.ptrAt(iC));
+      iPF = findPFIndex_(ptrToPF);
+      if (iPF < 0)
+        iPF = tracePFIndex_(ptrToPF);
+      if (iPF < 0) // misconfiguration
+        throw std::runtime_error(std::string("Cannot find candidate matching a ") + _inputName + " input");
+    }
+
+    edm::Ref<reco::CandidateView> inputRef(_inputHandle, iC);
+    _puppiPtrs[iPF] = _puppiMap[inputRef];
+  }
+}
+
+void
+PFCandsFiller::indexPFCandidates_(reco::CandidateView const& _inCands)
+{
+  for (auto& product : pfIndices_)
+    product.second.clear();
+
+  for (unsigned iC(0); iC != _inCands.size(); ++iC) {
+    auto ptrToPF(_inCands.ptrAt(iC)); // points to the original collection
+
+    auto pItr(pfIndices_.begin());
+    for (; pItr != pfIndices_.end(); ++pItr) {
+      if (pItr->first == ptrToPF.id())
+        break;
+    }
+    if (pItr == pfIndices_.end()) {
+      pfIndices_.emplace_back(ptrToPF.id(), std::vector<int>());
+      pItr = pfIndices_.end() - 1;
+    }
+
+    auto& indices(pItr->second);
+    if (ptrToPF.key() >= indices.size())
+      indices.resize(ptrToPF.key() + 1, -1);
+    indices[ptrToPF.key()] = iC;
+  }
+}
+
+int
+PFCandsFiller::findPFIndex_(reco::CandidatePtr const& _ptr) const
+{
+  for (auto& product : pfIndices_) {
+    if (product.first == _ptr.id())
+      return _ptr.key() < product.second.size() ? product.second[_ptr.key()] : -1;
+  }
+  return -1;
+}
+
+int
+PFCandsFiller::tracePFIndex_(reco::CandidatePtr const& _ptr)
+{
+  // The input to puppi had some layer(s) of PF candidate cloning. Trace back to the original PF
+  // collection through sourceCandidatePtr(). All candidates of a product are normally cloned
+  // the same way; the number of steps is cached per product to skip the lookups in between.
+
+  auto dItr(sourceDepths_.find(_ptr.id()));
+  if (dItr != sourceDepths_.end()) {
+    reco::CandidatePtr source(_ptr);
+    for (unsigned iD(0); iD != dItr->second && source.isNonnull(); ++iD)
+      source = source->sourceCandidatePtr(0);
+
+    if (source.isNonnull()) {
+      int iPF(findPFIndex_(source));
+      if (iPF >= 0)
+        return iPF;
+    }
+  }
+
+  reco::CandidatePtr source(_ptr);
+  unsigned depth(0);
+  while (source.isNonnull()) {
+    int iPF(findPFIndex_(source));
+    if (iPF >= 0) {
+      sourceDepths_[_ptr.id()] = depth;
+      return iPF;
+    }
+
+    if (source->numberOfSourceCandidatePtrs() == 0)
+      break;
+
+    source = source->sourceCandidatePtr(0);
+    ++depth;
+  }
+
+  return -1;
+}
+
+void
+PFCandsFiller::setRefs(ObjectMapStore const&)
 {
-  auto& vtxMap(_objectMaps.at("vertices").get<reco::Vertex, panda::RecoVertex>().fwdMap);
+  auto& vtxMap(vtxMap_->fwdMap);
 
   unsigned nVtx(orderedVertices_.size());
 
@@ -0,0 +1,183 @@
+#include "../interface/PerfCounters.h"
+
+#include <cmath>
+#include <limits>
+#include <iomanip>
+#include <cstring>
+#include <cstdint>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+namespace {
+
+  //! Counter group of one thread
+  class ThreadCounters {
+  public:
+    ThreadCounters();
+    ~ThreadCounters();
+
+    bool read(PerfCounters::Counts&);
+
+  private:
+    int fds_[PerfCounters::nCounters];
+    int index_[PerfCounters::nCounters]; //! position in the group read, -1 if not opened
+    int leader_{-1};
+    unsigned nOpen_{0};
+  };
+
+  ThreadCounters::ThreadCounters()
+  {
+    std::uint64_t const l1dMiss(PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+
+    std::uint32_t const types[PerfCounters::nCounters] = {
+      PERF_TYPE_HARDWARE,
+      PERF_TYPE_HARDWARE,
+      PERF_TYPE_HW_CACHE,
+      PERF_TYPE_HARDWARE,
+      PERF_TYPE_HARDWARE
+    };
+    std::uint64_t const configs[PerfCounters::nCounters] = {
+      PERF_COUNT_HW_CPU_CYCLES,
+      PERF_COUNT_HW_INSTRUCTIONS,
+      l1dMiss,
+      PERF_COUNT_HW_CACHE_MISSES, // last-level cache
+      PERF_COUNT_HW_BRANCH_MISSES
+    };
+
+    for (unsigned iC(0); iC != PerfCounters::nCounters; ++iC) {
+      fds_[iC] = -1;
+      index_[iC] = -1;
+
+      perf_event_attr attr;
+      std::memset(&attr, 0, sizeof(attr));
+      attr.size = sizeof(attr);
+      attr.type = types[iC];
+      attr.config = configs[iC];
+      attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+      attr.disabled = (leader_ < 0) ? 1 : 0;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+
+      // pid = 0, cpu = -1: this thread on any CPU
+      int fd(syscall(__NR_perf_event_open, &attr, 0, -1, leader_, 0));
+      if (fd < 0)
+        continue;
+
+      fds_[iC] = fd;
+      index_[iC] = nOpen_++;
+      if (leader_ < 0)
+        leader_ = fd;
+    }
+
+    if (leader_ >= 0)
+      ioctl(leader_, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+  }
+
+  ThreadCounters::~ThreadCounters()
+  {
+    for (int fd : fds_) {
+      if (fd >= 0)
+        close(fd);
+    }
+  }
+
+  bool
+  ThreadCounters::read(PerfCounters::Counts& _counts)
+  {
+    if (leader_ < 0)
+      return false;
+
+    // nr, time_enabled, time_running, values
+    std::uint64_t buffer[3 + PerfCounters::nCounters];
+    if (::read(leader_, buffer, sizeof(buffer)) < ssize_t((3 + nOpen_) * sizeof(std::uint64_t)))
+      return false;
+
+    double scale(buffer[2] == 0 ? 0. : double(buffer[1]) / buffer[2]);
+
+    for (unsigned iC(0); iC != PerfCounters::nCounters; ++iC) {
+      if (index_[iC] < 0)
+        _counts[iC] = std::numeric_limits<double>::quiet_NaN();
+      else
+        _counts[iC] = buffer[3 + index_[iC]] * scale;
+    }
+
+    return true;
+  }
+
+  thread_local ThreadCounters threadCounters;
+
+}
+
+/*static*/
+bool
+PerfCounters::read(Counts& _counts)
+{
+  return threadCounters.read(_counts);
+}
+
+#else
+
+/*static*/
+bool
+PerfCounters::read(Counts&)
+{
+  return false;
+}
+
+#endif
+
+/*static*/
+char const*
+PerfCounters::counterName(Counter _counter)
+{
+  switch (_counter) {
+  case kCycles:
+    return "cycles";
+  case kInstructions:
+    return "instructions";
+  case kL1DMisses:
+    return "L1D misses";
+  case kLLCMisses:
+    return "LLC misses";
+  case kBranchMisses:
+    return "branch misses";
+  default:
+    return "";
+  }
+}
+
+/*static*/
+void
+PerfCounters::print(std::ostream& _out, std::vector<std::string> const& _names, std::vector<Counts> const& _counts, unsigned long long _nEvents)
+{
+  if (_nEvents == 0)
+    return;
+
+  _out << std::setw(28) << std::left << " (per event)";
+  for (unsigned iC(0); iC != nCounters; ++iC)
+    _out << std::setw(15) << std::right << counterName(Counter(iC));
+  _out << std::setw(8) << "IPC" << std::endl;
+
+  for (unsigned iN(0); iN != _names.size() && iN != _counts.size(); ++iN) {
+    auto& counts(_counts[iN]);
+
+    _out << " " << std::setw(27) << std::left << _names[iN] << std::right << std::fixed;
+    for (unsigned iC(0); iC != nCounters; ++iC) {
+      if (std::isnan(counts[iC]))
+        _out << std::setw(15) << "n/a";
+      else
+        _out << std::setw(15) << std::setprecision(0) << counts[iC] / _nEvents;
+    }
+
+    if (counts[kCycles] > 0.)
+      _out << std::setw(8) << std::setprecision(2) << counts[kInstructions] / counts[kCycles];
+    else
+      _out << std::setw(8) << "n/a";
+
+    _out << std::endl;
+  }
+}
@@ -62,6 +62,17 @@ PhotonsFiller::branchNames(panda::utils::BranchList& _eventBranches, panda::util
     _eventBranches.emplace_back("!photons.triggerMatch");
 }
 
+void
+PhotonsFiller::dependencies(VString& _fillers) const
+{
+  _fillers.push_back("superClusters");
+  _fillers.push_back("pfCandidates");
+  if (!isRealData_)
+    _fillers.push_back("genParticles");
+  if (useTrigger_)
+    _fillers.push_back("hlt");
+}
+
 void
 PhotonsFiller::addOutput(TFile& _outputFile)
 {
@@ -71,6 +82,26 @@ PhotonsFiller::addOutput(TFile& _outputFile)
   delete t;
 }
 
+void
+PhotonsFiller::bookObjectMaps_()
+{
+  phoPhoMap_ = &objectMap_->get<reco::Photon, panda::Photon>();
+  scPhoMap_ = &objectMap_->get<reco::SuperCluster, panda::Photon>();
+  pfPhoMap_ = &objectMap_->get<reco::Candidate, panda::Photon>("pf");
+  genPhoMap_ = &objectMap_->get<reco::Candidate, panda::Photon>("gen");
+}
+
+void
+PhotonsFiller::resolveObjectMaps(ObjectMapStore const& _objectMaps)
+{
+  scMap_ = resolveObjectMap_<reco::SuperCluster, panda::SuperCluster>(_objectMaps, "superClusters");
+  pfMap_ = resolveObjectMap_<reco::Candidate, panda::PFCand>(_objectMaps, "pfCandidates");
+  if (!isRealData_)
+    genMap_ = resolveObjectMap_<reco::Candidate, panda::GenParticle>(_objectMaps, "genParticles");
+  if (useTrigger_)
+    hltNameMap_ = resolveObjectMap_<pat::TriggerObjectStandAlone, VString>(_objectMaps, "hlt");
+}
+
 void
 PhotonsFiller::fill(panda::Event& _outEvent, edm::Event const& _inEvent, edm::EventSetup const& _setup)
 {
@@ -302,13 +333,13 @@ PhotonsFiller::fill(panda::Event& _outEvent, edm::Event const& _inEvent, edm::Ev
     ptrList.push_back(inPhotons.ptrAt(iPh));
   }
 
-  auto originalIndices(outPhotons.sort(panda::Particle::PtGreater));
+  auto originalIndices(sortByPt(outPhotons));
 
   // make reco <-> panda mapping
-  auto& phoPhoMap(objectMap_->get<reco::Photon, panda::Photon>());
-  auto& scPhoMap(objectMap_->get<reco::SuperCluster, panda::Photon>());
-  auto& pfPhoMap(objectMap_->get<reco::Candidate, panda::Photon>("pf"));
-  auto& genPhoMap(objectMap_->get<reco::Candidate, panda::Photon>("gen"));
+  auto& phoPhoMap(*phoPhoMap_);
+  auto& scPhoMap(*scPhoMap_);
+  auto& pfPhoMap(*pfPhoMap_);
+  auto& genPhoMap(*genPhoMap_);
   
   for (unsigned iP(0); iP != outPhotons.size(); ++iP) {
     auto& outPhoton(outPhotons[iP]);
@@ -335,13 +366,13 @@ PhotonsFiller::fill(panda::Event& _outEvent, edm::Event const& _inEvent, edm::Ev
 }
 
 void
-PhotonsFiller::setRefs(ObjectMapStore const& _objectMaps)
+PhotonsFiller::setRefs(ObjectMapStore const&)
 {
-  auto& scPhoMap(objectMap_->get<reco::SuperCluster, panda::Photon>().bwdMap);
-  auto& pfPhoMap(objectMap_->get<reco::Candidate, panda::Photon>("pf"));
+  auto& scPhoMap(scPhoMap_->bwdMap);
+  auto& pfPhoMap(*pfPhoMap_);
 
-  auto& scMap(_objectMaps.at("superClusters").get<reco::SuperCluster, panda::SuperCluster>().fwdMap);
-  auto& pfMap(_objectMaps.at("pfCandidates").get<reco::Candidate, panda::PFCand>().fwdMap);
+  auto& scMap(scMap_->fwdMap);
+  auto& pfMap(pfMap_->fwdMap);
 
   for (auto& link : scPhoMap) { // panda -> edm
     auto& outPhoton(*link.first);
@@ -358,9 +389,9 @@ PhotonsFiller::setRefs(ObjectMapStore const& _objectMaps)
   }
 
   if (!isRealData_) {
-    auto& genPhoMap(objectMap_->get<reco::Candidate, panda::Photon>("gen"));
+    auto& genPhoMap(*genPhoMap_);
 
-    auto& genMap(_objectMaps.at("genParticles").get<reco::Candidate, panda::GenParticle>().fwdMap);
+    auto& genMap(genMap_->fwdMap);
 
     for (auto& link : genPhoMap.bwdMap) {
       auto& genPtr(link.second);
@@ -373,7 +404,7 @@ PhotonsFiller::setRefs(ObjectMapStore const& _objectMaps)
   }
 
   if (useTrigger_) {
-    auto& nameMap(_objectMaps.at("hlt").get<pat::TriggerObjectStandAlone, VString>().fwdMap);
+    auto& nameMap(hltNameMap_->fwdMap);
 
     std::vector<pat::TriggerObjectStandAlone const*> triggerObjects[panda::Photon::nTriggerObjects];
 
@@ -392,7 +423,7 @@ PhotonsFiller::setRefs(ObjectMapStore const& _objectMaps)
       }
     }
 
-    auto& phoPhoMap(objectMap_->get<reco::Photon, panda::Photon>().fwdMap);
+    auto& phoPhoMap(phoPhoMap_->fwdMap);
 
     for (auto& link : phoPhoMap) { // edm -> panda
       auto& inPhoton(*link.first);
@@ -20,6 +20,12 @@ SuperClustersFiller::branchNames(panda::utils::BranchList& _eventBranches, panda
   _eventBranches.emplace_back("superClusters");
 }
 
+void
+SuperClustersFiller::bookObjectMaps_()
+{
+  scMap_ = &objectMap_->get<reco::SuperCluster, panda::SuperCluster>();
+}
+
 void
 SuperClustersFiller::fill(panda::Event& _outEvent, edm::Event const& _inEvent, edm::EventSetup const& _setup)
 {
@@ -30,7 +36,7 @@ SuperClustersFiller::fill(panda::Event& _outEvent, edm::Event const& _inEvent, e
   auto& outSuperClusters(_outEvent.superClusters);
   outSuperClusters.reserve(inSuperClusters.size());
 
-  auto& objectMap(objectMap_->get<reco::SuperCluster, panda::SuperCluster>());
+  auto& objectMap(*scMap_);
 
   unsigned iSC(-1);
   for (auto& inSC : inSuperClusters) {
@@ -22,6 +22,30 @@ TausFiller::branchNames(panda::utils::BranchList& _eventBranches, panda::utils::
     _eventBranches.emplace_back("!taus.matchedGen_");
 }
 
+void
+TausFiller::dependencies(VString& _fillers) const
+{
+  _fillers.push_back("vertices");
+  if (!isRealData_)
+    _fillers.push_back("genParticles");
+}
+
+void
+TausFiller::bookObjectMaps_()
+{
+  tauMap_ = &objectMap_->get<reco::BaseTau, panda::Tau>();
+  vtxTauMap_ = &objectMap_->get<reco::Vertex, panda::Tau>();
+  genTauMap_ = &objectMap_->get<reco::Candidate, panda::Tau>();
+}
+
+void
+TausFiller::resolveObjectMaps(ObjectMapStore const& _objectMaps)
+{
+  vtxMap_ = resolveObjectMap_<reco::Vertex, panda::RecoVertex>(_objectMaps, "vertices");
+  if (!isRealData_)
+    genMap_ = resolveObjectMap_<reco::Candidate, panda::GenParticle>(_objectMaps, "genParticles");
+}
+
 void
 TausFiller::fill(panda::Event& _outEvent, edm::Event const& _inEvent, edm::EventSetup const& _setup)
 {
@@ -59,7 +83,7 @@ TausFiller::fill(panda::Event& _outEvent, edm::Event const& _inEvent, edm::Event
     ptrList.push_back(inTaus.ptrAt(iTau));
   }
 
-  auto originalIndices(outTaus.sort(panda::Particle::PtGreater));
+  auto originalIndices(sortByPt(outTaus));
 
   // export panda <-> reco mapping
 
@@ -74,9 +98,9 @@ TausFiller::fill(panda::Event& _outEvent, edm::Event const& _inEvent, edm::Event
     }
   } 
 
-  auto& objectMap(objectMap_->get<reco::BaseTau, panda::Tau>());
-  auto& vtxTauMap(objectMap_->get<reco::Vertex, panda::Tau>());
-  auto& genTauMap(objectMap_->get<reco::Candidate, panda::Tau>());
+  auto& objectMap(*tauMap_);
+  auto& vtxTauMap(*vtxTauMap_);
+  auto& genTauMap(*genTauMap_);
 
   for (unsigned iP(0); iP != outTaus.size(); ++iP) {
     auto& outTau(outTaus[iP]);
@@ -105,11 +129,11 @@ TausFiller::fill(panda::Event& _outEvent, edm::Event const& _inEvent, edm::Event
 }
 
 void
-TausFiller::setRefs(ObjectMapStore const& _objectMaps)
+TausFiller::setRefs(ObjectMapStore const&)
 {
-  auto& vtxTauMap(objectMap_->get<reco::Vertex, panda::Tau>());
+  auto& vtxTauMap(*vtxTauMap_);
 
-  auto& vtxMap(_objectMaps.at("vertices").get<reco::Vertex, panda::RecoVertex>().fwdMap);
+  auto& vtxMap(vtxMap_->fwdMap);
 
   for (auto& link : vtxTauMap.bwdMap) { // panda -> edm
     auto& outTau(*link.first);
@@ -119,9 +143,9 @@ TausFiller::setRefs(ObjectMapStore const& _objectMaps)
   }
 
   if (!isRealData_) {
-    auto& genTauMap(objectMap_->get<reco::Candidate, panda::Tau>());
+    auto& genTauMap(*genTauMap_);
 
-    auto& genMap(_objectMaps.at("genParticles").get<reco::Candidate, panda::GenParticle>().fwdMap);
+    auto& genMap(genMap_->fwdMap);
 
     for (auto& link : genTauMap.bwdMap) {
       auto& genPtr(link.second);
@@ -0,0 +1,91 @@
+#include "../interface/TraceRecorder.h"
+
+#include <atomic>
+#include <set>
+#include <iomanip>
+
+namespace {
+
+  unsigned
+  threadIndex()
+  {
+    static std::atomic<unsigned> nThreads(0);
+    thread_local unsigned index(nThreads++);
+    return index;
+  }
+
+  double
+  toUS(TraceRecorder::Clock::duration const& _interval)
+  {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(_interval).count() * 1.e-3;
+  }
+
+  void
+  writeString(std::ostream& _out, std::string const& _str)
+  {
+    _out << '"';
+    for (char c : _str) {
+      if (c == '"' || c == '\\')
+        _out << '\\';
+      _out << c;
+    }
+    _out << '"';
+  }
+
+}
+
+TraceRecorder::TraceRecorder(Clock::time_point _origin, unsigned _pid/* = 0*/) :
+  origin_(_origin),
+  pid_(_pid)
+{
+}
+
+void
+TraceRecorder::record(std::string const& _name, char const* _category, Clock::time_point _begin, Clock::time_point _end, unsigned long long _eventNumber)
+{
+  Span span{_name, _category, toUS(_begin - origin_), toUS(_end - _begin), pid_, threadIndex(), _eventNumber};
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  spans_.push_back(std::move(span));
+}
+
+void
+TraceRecorder::append(TraceRecorder const& _other)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  spans_.insert(spans_.end(), _other.spans_.begin(), _other.spans_.end());
+}
+
+void
+TraceRecorder::write(std::ostream& _out) const
+{
+  std::set<unsigned> pids;
+  for (auto& span : spans_)
+    pids.insert(span.pid);
+
+  _out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[" << std::endl;
+
+  bool first(true);
+  for (unsigned pid : pids) {
+    if (!first)
+      _out << "," << std::endl;
+    first = false;
+
+    _out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << pid << ",\"args\":{\"name\":\"stream " << pid << "\"}}";
+  }
+
+  _out << std::fixed << std::setprecision(3);
+
+  for (auto& span : spans_) {
+    if (!first)
+      _out << "," << std::endl;
+    first = false;
+
+    _out << "{\"name\":";
+    writeString(_out, span.name);
+    _out << ",\"cat\":\"" << span.category << "\",\"ph\":\"X\",\"ts\":" << span.begin << ",\"dur\":" << span.duration
+         << ",\"pid\":" << span.pid << ",\"tid\":" << span.tid << ",\"args\":{\"event\":" << span.eventNumber << "}}";
+  }
+
+  _out << std::endl << "]}" << std::endl;
+}
@@ -38,6 +38,12 @@ VerticesFiller::addOutput(TFile& _outputFile)
   }
 }
 
+void
+VerticesFiller::bookObjectMaps_()
+{
+  vtxMap_ = &objectMap_->get<reco::Vertex, panda::RecoVertex>();
+}
+
 void
 VerticesFiller::fill(panda::Event& _outEvent, edm::Event const& _inEvent, edm::EventSetup const&)
 {
@@ -49,7 +55,7 @@ VerticesFiller::fill(panda::Event& _outEvent, edm::Event const& _inEvent, edm::E
   auto& outVertices(_outEvent.vertices);
   outVertices.reserve(inVertices.size());
 
-  auto& objMap(objectMap_->get<reco::Vertex, panda::RecoVertex>());
+  auto& objMap(*vtxMap_);
 
   _outEvent.npv = npvCache_;
 
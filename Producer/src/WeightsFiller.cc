@@ -116,8 +116,7 @@ WeightsFiller::fill(panda::Event& _outEvent, edm::Event const&, edm::EventSetup
   _outEvent.genReweight.r5f5DW = normQCDVariations_[5] - 1.;
   _outEvent.genReweight.pdfDW = normQCDVariations_[6] - 1.;
 
-  // genParam branch is not filled from the outEvent object, but we copy the value here for consistence
-  // (some other filler module may decide to use the values!)
+  // genParam branch is filled from the output event (see bookGenParam_)
   // Unlike QCD variation reweights, genParam can represent anything and is not guaranteed to cluster around 1.
   // Therefore we save the normalized weights directly and do not subtract 1.
   std::copy(genParam_, genParam_ + wids_.size(), _outEvent.genReweight.genParam);
@@ -145,6 +144,13 @@ WeightsFiller::notifyNewProduct(edm::BranchDescription const& _bdesc, edm::Consu
   }
 }
 
+bool
+WeightsFiller::modifiesEventTree() const
+{
+  // genParam is booked in fillAll at the end of the learning phase
+  return !isRealData_ && !lheEventToken_.second.isUninitialized() && bufferCounter_ <= learningPhase;
+}
+
 void
 WeightsFiller::getLHEWeights_(LHEEventProduct const& _lheEvent)
 {
@@ -254,11 +260,16 @@ WeightsFiller::bookGenParam_()
     weightTree->Fill();
   }
 
+  // The branch is booked on the tree event. fill() copies genParam_ to the output event, which is the tree event
+  // itself or a buffer that the asynchronous writer points the branch to. Binding to genParam_ directly would not
+  // work when the tree is filled asynchronously.
+  float* genParam(treeEvent_->genReweight.genParam);
+
   auto* eventTree(static_cast<TTree*>(outputFile_->Get("events")));
-  auto* branch(eventTree->Branch("genReweight.genParam", genParam_, TString::Format("genParam[%d]/F", int(wids_.size()))));
+  auto* branch(eventTree->Branch("genReweight.genParam", genParam, TString::Format("genParam[%d]/F", int(wids_.size()))));
 
   for (unsigned iE(0); iE != learningPhase; ++iE) {
-    std::copy(genParamBuffer_[iE], genParamBuffer_[iE] + wids_.size(), genParam_);
+    std::copy(genParamBuffer_[iE], genParamBuffer_[iE] + wids_.size(), genParam);
     branch->Fill();
   }
 }
@@ -0,0 +1,644 @@
+// Standalone benchmark of the jet substructure kernels used in FatJetsFiller.
+//
+// Generates synthetic boosted-jet constituent sets of configurable multiplicity, times each kernel
+// per jet, and optionally writes or checks the kernel outputs against a reference file. The kernels
+// are chained as in FatJetsFiller: CA clustering with area + soft drop, ECFs of the leading soft-drop
+// constituents, N-subjettiness of the soft-drop constituents, and HTT on the leading CA jet. Typical use:
+//  pandaBenchmarkSubstructure -w ref.txt        (before a change)
+//  pandaBenchmarkSubstructure -c ref.txt        (after the change; exit code 1 on mismatch)
+// The same pair of commands with -a added to the second validates the area-free clustering mode of
+// FatJetsFiller (substructureAreas = False) against the default clustering with explicit ghosts.
+// The flat forest of BoostedBtaggingMVACalculator is validated against TMVA::Reader in the same process:
+//  pandaBenchmarkSubstructure -T 10000          (exit code 1 if any output differs beyond tolerance)
+// evaluates the double-b BDT with both engines on random inputs and on edge cases (inputs exactly at the
+// cut values of the forest, infinities, NaNs, which must give -999).
+//
+// Run with -h for the list of options.
+
+#include "PandaProd/Utilities/interface/EnergyCorrelations.h"
+#include "PandaProd/Utilities/interface/HierarchicalNjettiness.h"
+#include "PandaProd/Utilities/interface/HEPTopTaggerWrapperV2.h"
+#include "PandaProd/Utilities/interface/BoostedBtaggingMVACalculator.h"
+
+#include "fastjet/PseudoJet.hh"
+#include "fastjet/JetDefinition.hh"
+#include "fastjet/GhostedAreaSpec.hh"
+#include "fastjet/AreaDefinition.hh"
+#include "fastjet/ClusterSequenceArea.hh"
+#include "fastjet/contrib/SoftDrop.hh"
+#include "fastjet/contrib/Njettiness.hh"
+#include "fastjet/contrib/MeasureDefinition.hh"
+
+#include "TMVA/Reader.h"
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <random>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <cstdlib>
+#include <unistd.h>
+
+typedef std::chrono::steady_clock SClock;
+typedef std::vector<fastjet::PseudoJet> VPseudoJet;
+typedef std::map<std::string, double> ValueMap;
+
+//! Deterministic generator of synthetic jets (independent of the standard library distributions)
+class JetGenerator {
+public:
+  JetGenerator(unsigned seed) : engine_(seed) {}
+
+  //! Uniform in [0, 1)
+  double uniform() { return engine_() / 4294967296.; }
+  //! Box-Muller
+  double gaus(double mean, double sigma)
+  {
+    double u1(1. - uniform());
+    double u2(uniform());
+    return mean + sigma * std::sqrt(-2. * std::log(u1)) * std::cos(2. * M_PI * u2);
+  }
+
+  //! Three-prong jet of total pT ~ 500 GeV around (eta, phi) = (0, 0) with a soft diffuse component
+  VPseudoJet generate(unsigned nConstituents, double R);
+
+private:
+  std::mt19937 engine_;
+};
+
+VPseudoJet
+JetGenerator::generate(unsigned _nConstituents, double _R)
+{
+  // prong axes and pT fractions
+  double prongEta[3];
+  double prongPhi[3];
+  double prongFrac[3] = {0.5, 0.3, 0.2};
+  for (unsigned iP(0); iP != 3; ++iP) {
+    prongEta[iP] = gaus(0., 0.25 * _R);
+    prongPhi[iP] = gaus(0., 0.25 * _R);
+  }
+
+  double const jetPt(500.);
+  unsigned nSoft(_nConstituents / 5);
+  unsigned nHard(_nConstituents - nSoft);
+
+  VPseudoJet constituents;
+  constituents.reserve(_nConstituents);
+
+  for (unsigned iC(0); iC != _nConstituents; ++iC) {
+    double pt, eta, phi;
+    if (iC < nHard) {
+      unsigned iP(iC % 3);
+      // steeply falling pT spectrum within the prong
+      pt = 0.9 * jetPt * prongFrac[iP] / (nHard / 3. + 1.) * -std::log(1. - uniform() * 0.999);
+      eta = gaus(prongEta[iP], 0.05 * _R);
+      phi = gaus(prongPhi[iP], 0.05 * _R);
+    }
+    else {
+      pt = 0.1 * jetPt / (nSoft + 1.) * 2. * uniform();
+      double r(_R * std::sqrt(uniform()));
+      double a(2. * M_PI * uniform());
+      eta = r * std::cos(a);
+      phi = r * std::sin(a);
+    }
+
+    if (pt < 0.02)
+      pt = 0.02;
+
+    fastjet::PseudoJet cand;
+    cand.reset_PtYPhiM(pt, eta, phi, 0.);
+    constituents.push_back(cand);
+  }
+
+  return constituents;
+}
+
+//! Configuration of the kernels, mirroring FatJetsFiller
+struct Kernels {
+  Kernels(double R, std::string const& mvaWeights);
+
+  double R;
+  fastjet::GhostedAreaSpec activeArea;
+  fastjet::AreaDefinition areaDef;
+  fastjet::JetDefinition jetDefCA;
+  fastjet::contrib::SoftDrop softdrop;
+  fastjet::contrib::Njettiness tau;
+  HierarchicalNjettiness tauAll;
+  std::unique_ptr<fastjet::HEPTopTaggerV2> htt;
+  panda::BoostedBtaggingMVACalculator mva;
+};
+
+Kernels::Kernels(double _R, std::string const& _mvaWeights) :
+  R(_R),
+  activeArea(7., 1, 0.01),
+  areaDef(fastjet::active_area_explicit_ghosts, activeArea),
+  jetDefCA(fastjet::cambridge_algorithm, _R),
+  softdrop(1., 0.15, _R),
+  tau(fastjet::contrib::OnePass_KT_Axes(), fastjet::contrib::NormalizedMeasure(1., _R)),
+  tauAll(fastjet::contrib::NormalizedMeasure(1., _R), 3)
+{
+  htt.reset(new fastjet::HEPTopTaggerV2(true, false, // optimalR, doHTTQ
+                                        0., 0., // minSJPt, minCandPt
+                                        30., 0.8, // sjmass, mucut
+                                        0.3, 5, // filtR, filtN
+                                        4, 0., // mode, minCandMass
+                                        9999999., 9999999., // maxCandMass, massRatioWidth
+                                        0., 0., // minM23Cut, minM13Cut
+                                        9999999., false)); // maxM13Cut, rejectMinR
+
+  if (!_mvaWeights.empty())
+    mva.initialize("BDT", _mvaWeights);
+}
+
+//! Inputs prepared for one jet
+struct JetInput {
+  VPseudoJet constituents;
+  std::unique_ptr<fastjet::ClusterSequence> sequence;
+  fastjet::PseudoJet leadingJet;
+  VPseudoJet sdConstituents; //! soft-drop constituents (sorted by pT)
+  VPseudoJet ecfConstituents; //! leading soft-drop constituents used for the ECFs
+};
+
+//! Timing result of one kernel at one multiplicity
+struct Timing {
+  double total{0.}; // us
+  double min{-1.}; // us per call
+  unsigned long nCalls{0};
+};
+
+void
+printUsage(char const* _argv0)
+{
+  std::cerr << "Usage: " << _argv0 << " [options]" << std::endl;
+  std::cerr << "  -n N1,N2,...  constituent multiplicities (default 20,50,100,200,400)" << std::endl;
+  std::cerr << "  -j N          jets per multiplicity (default 10)" << std::endl;
+  std::cerr << "  -r N          repetitions per jet (default 3)" << std::endl;
+  std::cerr << "  -k K1,K2,...  kernels to run among ecf,ecfn,ecfcalc,cluster,tau,tauall,htt,mva,mvabatch (default all)" << std::endl;
+  std::cerr << "  -e N          ECFs use the N hardest soft-drop constituents (default 100 as in FatJetsFiller; 0: all)" << std::endl;
+  std::cerr << "  -a            cluster without ghost areas" << std::endl;
+  std::cerr << "  -R R          jet radius (default 1.5)" << std::endl;
+  std::cerr << "  -s SEED       random seed (default 12345)" << std::endl;
+  std::cerr << "  -m FILE       BDT weights for mva (default $CMSSW_BASE/src/PandaProd/Utilities/data/BoostedSVDoubleCA15_withSubjet_v4.weights.xml)" << std::endl;
+  std::cerr << "  -w FILE       write kernel outputs to FILE" << std::endl;
+  std::cerr << "  -c FILE       check kernel outputs against FILE" << std::endl;
+  std::cerr << "  -t TOL        relative tolerance of the check (default 0: exact)" << std::endl;
+  std::cerr << "  -T N          compare the BDT with TMVA::Reader on N random inputs and edge cases and exit (tolerance -t, default 1e-6)" << std::endl;
+}
+
+std::vector<std::string>
+splitList(std::string const& _list)
+{
+  std::vector<std::string> items;
+  std::istringstream ss(_list);
+  std::string item;
+  while (std::getline(ss, item, ','))
+    items.push_back(item);
+  return items;
+}
+
+//! Evaluate the double-b BDT with BoostedBtaggingMVACalculator and TMVA::Reader on the same inputs
+/*!
+ * Inputs are nRandom random sets, sets with one variable exactly at each cut value of the forest (the
+ * boundary of input >= cut), sets with infinities, and sets with NaNs. Returns the number of mismatches.
+ */
+unsigned
+compareTMVA(std::string const& _weights, unsigned _nRandom, JetGenerator& _generator, double _tolerance)
+{
+  unsigned const nV(panda::BoostedBtaggingMVACalculator::kNVariables);
+
+  panda::BoostedBtaggingMVACalculator calculator;
+  calculator.initialize("BDT", _weights);
+
+  float readerInputs[nV];
+  float spectators[5] = {};
+  TMVA::Reader reader("!Color:Silent");
+  for (unsigned iV(0); iV != nV; ++iV)
+    reader.AddVariable(panda::BoostedBtaggingMVACalculator::variableNames[iV], readerInputs + iV);
+  char const* spectatorNames[] = {"massPruned", "flavour", "nbHadrons", "ptPruned", "etaPruned"};
+  for (unsigned iS(0); iS != 5; ++iS)
+    reader.AddSpectator(spectatorNames[iS], spectators + iS);
+  reader.BookMVA("BDT", _weights);
+
+  // cut values of the forest, per variable, read directly from the weights file
+  std::vector<std::set<float>> cuts(nV);
+  {
+    std::ifstream in(_weights);
+    std::string line;
+    while (std::getline(in, line)) {
+      size_t ivar(line.find("IVar=\""));
+      size_t cut(line.find("Cut=\""));
+      if (line.find("<Node") == std::string::npos || ivar == std::string::npos || cut == std::string::npos)
+        continue;
+      int iV(std::atoi(line.c_str() + ivar + 6));
+      if (iV >= 0 && unsigned(iV) < nV)
+        cuts[iV].insert(std::strtof(line.c_str() + cut + 5, nullptr));
+    }
+  }
+
+  auto randomInputs([&_generator](float* _inputs) {
+      for (unsigned iV(0); iV != nV; ++iV)
+        _inputs[iV] = _generator.gaus(0., 5.);
+      _inputs[0] = _generator.uniform(); // subjet CSV
+    });
+
+  std::vector<float> inputs;
+  std::vector<float> row(nV);
+  for (unsigned iE(0); iE != _nRandom; ++iE) {
+    randomInputs(row.data());
+    inputs.insert(inputs.end(), row.begin(), row.end());
+  }
+  for (unsigned iV(0); iV != nV; ++iV) {
+    for (float cut : cuts[iV]) {
+      randomInputs(row.data());
+      row[iV] = cut;
+      inputs.insert(inputs.end(), row.begin(), row.end());
+    }
+  }
+  float const specials[] = {std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity(),
+                            std::numeric_limits<float>::quiet_NaN()};
+  for (float special : specials) {
+    for (unsigned iV(0); iV != nV; ++iV) {
+      randomInputs(row.data());
+      row[iV] = special;
+      inputs.insert(inputs.end(), row.begin(), row.end());
+    }
+    std::fill(row.begin(), row.end(), special);
+    inputs.insert(inputs.end(), row.begin(), row.end());
+  }
+
+  unsigned nEval(inputs.size() / nV);
+  std::vector<float> values(nEval);
+  calculator.mvaValues(inputs.data(), nEval, values.data());
+
+  unsigned nFailed(0);
+  for (unsigned iE(0); iE != nEval; ++iE) {
+    float const* eventInputs(inputs.data() + iE * nV);
+    std::copy(eventInputs, eventInputs + nV, readerInputs);
+    double reference(reader.EvaluateMVA("BDT"));
+
+    bool hasNaN(std::any_of(eventInputs, eventInputs + nV, [](float x) { return std::isnan(x); }));
+    double value(values[iE]);
+    // the single-jet interface must agree with the batch
+    float single(calculator.mvaValue(0., -1, -1, 0., 0., eventInputs[0], eventInputs[1], eventInputs[2], eventInputs[3],
+                                     eventInputs[4], eventInputs[5], eventInputs[6], eventInputs[7], eventInputs[8], eventInputs[9],
+                                     eventInputs[10], eventInputs[11], eventInputs[12], eventInputs[13], eventInputs[14], eventInputs[15],
+                                     eventInputs[16], eventInputs[17], eventInputs[18], eventInputs[19], eventInputs[20], eventInputs[21],
+                                     eventInputs[22], eventInputs[23], eventInputs[24], eventInputs[25], eventInputs[26], eventInputs[27]));
+
+    bool match(std::abs(value - reference) <= _tolerance * std::max(1., std::abs(reference)) && single == values[iE]);
+    if (hasNaN)
+      match = (value == -999. && reference == -999. && single == -999.);
+
+    if (!match) {
+      if (nFailed < 20) {
+        std::cerr << "Mismatch at input set " << iE << ": " << std::setprecision(17) << value << " (single " << single
+                  << ", TMVA " << reference << "); inputs";
+        for (unsigned iV(0); iV != nV; ++iV)
+          std::cerr << " " << eventInputs[iV];
+        std::cerr << std::endl;
+      }
+      ++nFailed;
+    }
+  }
+
+  unsigned nCuts(0);
+  for (auto& varCuts : cuts)
+    nCuts += varCuts.size();
+
+  std::cout << "Compared " << nEval << " BDT evaluations with TMVA::Reader (" << _nRandom << " random, "
+            << nCuts << " at cut values, " << 3 * (nV + 1) << " with infinities or NaNs): " << nFailed << " mismatches" << std::endl;
+
+  return nFailed;
+}
+
+int
+main(int argc, char** argv)
+{
+  std::vector<unsigned> sizes{20, 50, 100, 200, 400};
+  unsigned nJets(10);
+  unsigned nRepeat(3);
+  std::set<std::string> kernelNames{"ecf", "ecfn", "ecfcalc", "cluster", "tau", "tauall", "htt", "mva", "mvabatch"};
+  unsigned maxECFConstituents(100);
+  bool useAreas(true);
+  double R(1.5);
+  unsigned seed(12345);
+  std::string mvaWeights;
+  std::string writeName;
+  std::string checkName;
+  double tolerance(-1.);
+  unsigned nCompareTMVA(0);
+
+  if (std::getenv("CMSSW_BASE"))
+    mvaWeights = std::string(std::getenv("CMSSW_BASE")) + "/src/PandaProd/Utilities/data/BoostedSVDoubleCA15_withSubjet_v4.weights.xml";
+
+  int opt;
+  while ((opt = getopt(argc, argv, "n:j:r:k:e:aR:s:m:w:c:t:T:h")) != -1) {
+    switch (opt) {
+    case 'n':
+      sizes.clear();
+      for (auto& item : splitList(optarg))
+        sizes.push_back(std::stoul(item));
+      break;
+    case 'j':
+      nJets = std::stoul(optarg);
+      break;
+    case 'r':
+      nRepeat = std::stoul(optarg);
+      break;
+    case 'k':
+      kernelNames.clear();
+      for (auto& item : splitList(optarg))
+        kernelNames.insert(item);
+      break;
+    case 'e':
+      maxECFConstituents = std::stoul(optarg);
+      break;
+    case 'a':
+      useAreas = false;
+      break;
+    case 'R':
+      R = std::stod(optarg);
+      break;
+    case 's':
+      seed = std::stoul(optarg);
+      break;
+    case 'm':
+      mvaWeights = optarg;
+      break;
+    case 'w':
+      writeName = optarg;
+      break;
+    case 'c':
+      checkName = optarg;
+      break;
+    case 't':
+      tolerance = std::stod(optarg);
+      break;
+    case 'T':
+      nCompareTMVA = std::stoul(optarg);
+      break;
+    default:
+      printUsage(argv[0]);
+      return opt == 'h' ? 0 : 2;
+    }
+  }
+
+  if (nRepeat == 0)
+    nRepeat = 1;
+
+  if (nCompareTMVA != 0) {
+    if (mvaWeights.empty() || !std::ifstream(mvaWeights)) {
+      std::cerr << "BDT weights file not found" << std::endl;
+      return 2;
+    }
+    JetGenerator generator(seed);
+    return compareTMVA(mvaWeights, nCompareTMVA, generator, tolerance < 0. ? 1.e-6 : tolerance) == 0 ? 0 : 1;
+  }
+
+  if (tolerance < 0.)
+    tolerance = 0.;
+
+  bool runMVA(kernelNames.count("mva") != 0 || kernelNames.count("mvabatch") != 0);
+  if (runMVA && (mvaWeights.empty() || !std::ifstream(mvaWeights))) {
+    std::cerr << "BDT weights file not found; skipping mva" << std::endl;
+    runMVA = false;
+    mvaWeights.clear();
+  }
+
+  fastjet::ClusterSequence::set_fastjet_banner_stream(0);
+
+  Kernels kernels(R, runMVA ? mvaWeights : "");
+
+  double betas[] = {0.5, 1., 2., 4.};
+  ECFCalculator ecfCalculator({0.5, 1., 2., 4.});
+
+  // outputs of all kernels, keyed by kernel/size/jet/quantity
+  ValueMap values;
+
+  // kernel name -> size -> timing
+  std::vector<std::string> kernelOrder;
+  std::map<std::string, std::map<unsigned, Timing>> timings;
+
+  auto timeKernel([&](std::string const& _name, unsigned _size, std::function<void()> const& _func) {
+      if (timings.count(_name) == 0)
+        kernelOrder.push_back(_name);
+
+      auto& timing(timings[_name][_size]);
+      for (unsigned iR(0); iR != nRepeat; ++iR) {
+        auto start(SClock::now());
+        _func();
+        double us(std::chrono::duration_cast<std::chrono::nanoseconds>(SClock::now() - start).count() * 1.e-3);
+        timing.total += us;
+        if (timing.min < 0. || us < timing.min)
+          timing.min = us;
+        ++timing.nCalls;
+      }
+    });
+
+  JetGenerator generator(seed);
+
+  for (unsigned size : sizes) {
+    std::vector<JetInput> inputs(nJets);
+    for (auto& input : inputs)
+      input.constituents = generator.generate(size, R);
+
+    for (unsigned iJ(0); iJ != nJets; ++iJ) {
+      auto& input(inputs[iJ]);
+      std::string prefix("/n" + std::to_string(size) + "/j" + std::to_string(iJ));
+
+      // clustering is the input to the ECFs, tau, and htt and is always performed
+      auto clusterFunc([&kernels, &input, useAreas]() {
+          if (useAreas)
+            input.sequence.reset(new fastjet::ClusterSequenceArea(input.constituents, kernels.jetDefCA, kernels.areaDef));
+          else
+            input.sequence.reset(new fastjet::ClusterSequence(input.constituents, kernels.jetDefCA));
+          VPseudoJet alljets(fastjet::sorted_by_pt(input.sequence->inclusive_jets(0.1)));
+          input.leadingJet = alljets.empty() ? fastjet::PseudoJet() : alljets[0];
+          if (alljets.empty())
+            return;
+          fastjet::PseudoJet sdJet(kernels.softdrop(input.leadingJet));
+          input.sdConstituents = fastjet::sorted_by_pt(sdJet.constituents());
+        });
+
+      if (kernelNames.count("cluster") != 0)
+        timeKernel("cluster", size, clusterFunc);
+      else
+        clusterFunc();
+
+      unsigned nECF(input.sdConstituents.size());
+      if (maxECFConstituents != 0 && nECF > maxECFConstituents)
+        nECF = maxECFConstituents;
+      input.ecfConstituents.assign(input.sdConstituents.begin(), input.sdConstituents.begin() + nECF);
+
+      values["cluster" + prefix + "/m"] = input.leadingJet.m();
+      // ghosts (pt ~ 1e-100) are not counted so that the outputs are comparable with and without areas
+      values["cluster" + prefix + "/nSD"] = std::count_if(input.sdConstituents.begin(), input.sdConstituents.end(), [](fastjet::PseudoJet const& c) { return c.perp() > 1.e-50; });
+
+      if (kernelNames.count("ecf") != 0 && !input.ecfConstituents.empty()) {
+        for (unsigned iB(0); iB != 4; ++iB) {
+          double n[4];
+          timeKernel("ecf", size, [&]() { calcECF(betas[iB], input.ecfConstituents, n, n + 1, n + 2, n + 3); });
+          for (unsigned iN(0); iN != 4; ++iN)
+            values["ecf" + prefix + "/b" + std::to_string(iB) + "/" + std::to_string(iN + 1)] = n[iN];
+        }
+      }
+
+      if (kernelNames.count("ecfn") != 0 && !input.ecfConstituents.empty()) {
+        ECFNManager manager;
+        for (unsigned iB(0); iB != 4; ++iB) {
+          timeKernel("ecfn", size, [&]() { calcECFN(betas[iB], input.ecfConstituents, &manager); });
+          for (int N : {1, 2, 3, 4}) {
+            for (int order : {1, 2, 3})
+              values["ecfn" + prefix + "/b" + std::to_string(iB) + "/" + std::to_string(N) + "_" + std::to_string(order)] = manager.ecfns[TString::Format("%i_%i", N, order)];
+          }
+        }
+      }
+
+      // all betas in one call, as in FatJetsFiller
+      if (kernelNames.count("ecfcalc") != 0 && !input.ecfConstituents.empty()) {
+        timeKernel("ecfcalc", size, [&]() { ecfCalculator.calculate(input.ecfConstituents); });
+        for (unsigned iB(0); iB != 4; ++iB) {
+          for (int N : {1, 2, 3, 4}) {
+            for (int order : {1, 2, 3})
+              values["ecfcalc" + prefix + "/b" + std::to_string(iB) + "/" + std::to_string(N) + "_" + std::to_string(order)] = ecfCalculator.get(iB, N, order);
+          }
+        }
+      }
+
+      if (kernelNames.count("tau") != 0 && !input.sdConstituents.empty()) {
+        double taus[3];
+        timeKernel("tau", size, [&]() {
+            for (unsigned iN(0); iN != 3; ++iN)
+              taus[iN] = kernels.tau.getTau(iN + 1, input.sdConstituents);
+          });
+        for (unsigned iN(0); iN != 3; ++iN)
+          values["tau" + prefix + "/" + std::to_string(iN + 1)] = taus[iN];
+      }
+
+      // tau_1 .. tau_3 with a shared seeding clustering, as in FatJetsFiller
+      if (kernelNames.count("tauall") != 0 && !input.sdConstituents.empty()) {
+        double taus[3];
+        timeKernel("tauall", size, [&]() { kernels.tauAll.getTaus(input.sdConstituents, taus); });
+        for (unsigned iN(0); iN != 3; ++iN)
+          values["tauall" + prefix + "/" + std::to_string(iN + 1)] = taus[iN];
+      }
+
+      if (kernelNames.count("htt") != 0 && input.leadingJet.has_valid_cluster_sequence()) {
+        double mass(-1.);
+        double frec(-1.);
+        timeKernel("htt", size, [&]() {
+            fastjet::PseudoJet httJet(kernels.htt->result(input.leadingJet));
+            if (httJet != 0) {
+              auto* s(static_cast<fastjet::HEPTopTaggerV2Structure*>(httJet.structure_non_const_ptr()));
+              mass = s->top_mass();
+              frec = s->fRec();
+            }
+          });
+        values["htt" + prefix + "/mass"] = mass;
+        values["htt" + prefix + "/frec"] = frec;
+      }
+    }
+  }
+
+  if (runMVA) {
+    // the BDT does not depend on the constituents; evaluate on random inputs
+    unsigned nEval(nJets * sizes.size());
+    std::vector<float> batchInputs;
+    for (unsigned iE(0); iE != nEval; ++iE) {
+      float vars[33];
+      for (auto& v : vars)
+        v = generator.gaus(0., 5.);
+      vars[5] = generator.uniform(); // subjet CSV
+
+      // the first five are spectators
+      batchInputs.insert(batchInputs.end(), vars + 5, vars + 33);
+
+      if (kernelNames.count("mva") == 0)
+        continue;
+
+      float value(0.);
+      timeKernel("mva", 0, [&]() {
+          value = kernels.mva.mvaValue(vars[0], -1, -1, vars[3], vars[4], vars[5], vars[6], vars[7], vars[8], vars[9],
+                                       vars[10], vars[11], vars[12], vars[13], vars[14], vars[15], vars[16], vars[17], vars[18], vars[19],
+                                       vars[20], vars[21], vars[22], vars[23], vars[24], vars[25], vars[26], vars[27], vars[28], vars[29],
+                                       vars[30], vars[31], vars[32]);
+        });
+      values["mva/e" + std::to_string(iE)] = value;
+    }
+
+    if (kernelNames.count("mvabatch") != 0) {
+      // all jets in one call; the size column of the timing table is the number of jets
+      std::vector<float> batchValues(nEval);
+      timeKernel("mvabatch", nEval, [&]() {
+          kernels.mva.mvaValues(batchInputs.data(), nEval, batchValues.data());
+        });
+      for (unsigned iE(0); iE != nEval; ++iE)
+        values["mvabatch/e" + std::to_string(iE)] = batchValues[iE];
+    }
+  }
+
+  std::cout << std::setw(10) << std::left << "kernel" << std::setw(8) << std::right << "nConst"
+            << std::setw(10) << "calls" << std::setw(16) << "mean (us)" << std::setw(16) << "min (us)" << std::endl;
+  for (auto& name : kernelOrder) {
+    for (auto& entry : timings[name]) {
+      auto& timing(entry.second);
+      std::cout << std::setw(10) << std::left << name << std::setw(8) << std::right;
+      if (entry.first == 0)
+        std::cout << "-";
+      else
+        std::cout << entry.first;
+      std::cout << std::setw(10) << timing.nCalls << std::fixed << std::setprecision(2)
+                << std::setw(16) << timing.total / timing.nCalls << std::setw(16) << timing.min << std::endl;
+    }
+  }
+
+  if (!writeName.empty()) {
+    std::ofstream out(writeName);
+    out << std::setprecision(17);
+    for (auto& entry : values)
+      out << entry.first << " " << entry.second << std::endl;
+    std::cout << "Wrote " << values.size() << " values to " << writeName << std::endl;
+  }
+
+  if (!checkName.empty()) {
+    std::ifstream in(checkName);
+    if (!in) {
+      std::cerr << "Cannot open " << checkName << std::endl;
+      return 2;
+    }
+
+    unsigned nChecked(0);
+    unsigned nFailed(0);
+    std::string key;
+    double reference;
+    while (in >> key >> reference) {
+      auto vItr(values.find(key));
+      if (vItr == values.end())
+        continue;
+
+      ++nChecked;
+      double value(vItr->second);
+      double scale(std::max(std::abs(reference), std::abs(value)));
+      if (value != reference && !(std::abs(value - reference) <= tolerance * scale)) {
+        if (nFailed < 20)
+          std::cerr << "Mismatch " << key << ": " << std::setprecision(17) << value << " (reference " << reference << ")" << std::endl;
+        ++nFailed;
+      }
+    }
+
+    std::cout << "Checked " << nChecked << " values against " << checkName << ": " << nFailed << " mismatches" << std::endl;
+    if (nChecked == 0 || nFailed != 0)
+      return 1;
+  }
+
+  return 0;
+}
@@ -1,27 +1,30 @@
 #ifndef PANDAPROD_NTUPLER_FUNCTIONS_BOOSTEDBTAGGINGMVACALCULATOR_HH
 #define PANDAPROD_NTUPLER_FUNCTIONS_BOOSTEDBTAGGINGMVACALCULATOR_HH
 
-#include <string>
+#include "GradBoostForest.h"
 
-// forward class declarations
-namespace TMVA {
-  class Reader;
-}
+#include <string>
 
 namespace panda {
 
   class BoostedBtaggingMVACalculator
   {
     public:
-      
+      //! Number of input variables of the BDT (spectators not included)
+      static constexpr unsigned kNVariables = 28;
+      //! Names of the input variables, in the order of the inputs to mvaValues
+      static char const* const variableNames[kNVariables];
+
       BoostedBtaggingMVACalculator();
       ~BoostedBtaggingMVACalculator();
-      
+
+      //! Load the BDT. MethodTag is kept for compatibility with the TMVA::Reader interface and is not used.
       void initialize(
                       const std::string MethodTag, const std::string WeightFile);
-      
+
       bool isInitialized() const {return fIsInitialized;}
-      
+
+      //! The spectator variables (massPruned, flavour, nbHadrons, ptPruned, etaPruned) do not enter the BDT.
       float mvaValue(
 	 	     		     const float massPruned, const float flavour, const float nbHadrons, const float ptPruned, const float etaPruned,
                                      const float SubJet_csv,const float z_ratio, const float trackSipdSig_3, const float trackSipdSig_2, const float trackSipdSig_1,
@@ -31,51 +34,20 @@ namespace panda {
                                      const float tau1_trackEtaRel_0, const float tau1_trackEtaRel_1, const float tau1_trackEtaRel_2, const float tau_vertexMass_0,
                                      const float tau_vertexEnergyRatio_0, const float tau_vertexDeltaR_0, const float tau_flightDistance2dSig_0, const float tau_vertexMass_1,
                                      const float tau_vertexEnergyRatio_1, const float tau_flightDistance2dSig_1, const float jetNTracks, const float nSV,
-		     		     const bool printDebug=false);
-     
-    
+		     		     const bool printDebug=false) const;
+
+      //! Evaluate nJets jets at once.
+      /*!
+       * inputs holds kNVariables values per jet, back to back, in the order of variableNames.
+       * values are -2 if the calculator was initialized without a weight file.
+       */
+      void mvaValues(float const* inputs, unsigned nJets, float* values) const;
+
     private:
-      void initReader(TMVA::Reader *reader, const std::string filename);
-      
       bool fIsInitialized;
-      
-      TMVA::Reader *fReader;
+
+      GradBoostForest fForest;
       std::string fMethodTag;
-      // input variables to compute MVA value
-      //
-      float _SubJet_csv;
-			float  _z_ratio ;
-			float  _trackSipdSig_3 ;
-			float _trackSipdSig_2;
-			float _trackSipdSig_1;
-			float _trackSipdSig_0;
-			float _trackSipdSig_1_0;
-			float _trackSipdSig_0_0;
-			float _trackSipdSig_1_1;
-			float _trackSipdSig_0_1;
-			float _trackSip2dSigAboveCharm_0;
-			float _trackSip2dSigAboveBottom_0;
-			float _trackSip2dSigAboveBottom_1;
-			float _tau0_trackEtaRel_0;
-			float _tau0_trackEtaRel_1;
-			float _tau0_trackEtaRel_2;
-			float _tau1_trackEtaRel_0;
-			float _tau1_trackEtaRel_1;
-			float _tau1_trackEtaRel_2;
-			float _tau_vertexMass_0;
-			float _tau_vertexEnergyRatio_0;
-			float _tau_vertexDeltaR_0;
-			float _tau_flightDistance2dSig_0;
-			float _tau_vertexMass_1;
-			float _tau_vertexEnergyRatio_1;
-			float _tau_flightDistance2dSig_1;
-			float _massPruned;
-			float _flavour;
-			float _ptPruned;
-			float _etaPruned;
-      float _jetNTracks;
-			float _nSV;
-		  float	_nbHadrons;
   };
 }
 #endif
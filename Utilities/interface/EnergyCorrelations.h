@@ -4,8 +4,10 @@
  * \author S.Narayanan
  */
 #include "fastjet/PseudoJet.hh"
+#include "PandaProd/Utilities/interface/PairwiseDeltaR2.h"
 #include <vector>
 #include <map>
+#include <array>
 #include "TMath.h"
 #include "TString.h"
 
@@ -18,7 +20,7 @@
  * @param  j2 second jet
  * @return    \f$dR^2\f$
  */
-double DeltaR2(fastjet::PseudoJet j1, fastjet::PseudoJet j2);
+double DeltaR2(fastjet::PseudoJet const& j1, fastjet::PseudoJet const& j2);
 
 /**
  * \brief Calculates un-normalized ECFs.
@@ -35,6 +37,9 @@ void calcECF(double beta, std::vector<fastjet::PseudoJet> &constituents, double
 
 /**
  * \brief Just a bunch of floats and bools ot hold different values of normalized ECFs
+ *
+ * String-keyed interface kept for compatibility with calcECFN. New code should use ECFCalculator,
+ * which stores the results of all betas in an ecfn::Table.
  */
 class ECFNManager {
 public:
@@ -55,6 +60,88 @@ public:
 
 };
 
+/**
+ * \brief Fixed layout of normalized ECF results and flags
+ *
+ * Results are indexed by (beta index, N, order) with order fastest, flags by (N, order).
+ * The layout matches the (order, N, beta) arguments of panda::FatJet::set_ecf.
+ */
+namespace ecfn {
+  constexpr int kMaxN = 4;
+  constexpr int kMaxOrder = 3;
+  constexpr unsigned kMaxBetas = 4;
+  constexpr unsigned kNFlags = kMaxN * kMaxOrder;
+  constexpr unsigned kNSlots = kMaxBetas * kNFlags;
+
+  //! Index of the ECF (N, order) of the iBeta-th beta in a Table
+  constexpr unsigned slot(unsigned iBeta, int N, int order) { return iBeta * kNFlags + (N - 1) * kMaxOrder + order - 1; }
+  //! Index of the (N, order) flag in a Flags
+  constexpr unsigned flagSlot(int N, int order) { return (N - 1) * kMaxOrder + order - 1; }
+
+  typedef std::array<double, kNSlots> Table;
+  typedef std::array<bool, kNFlags> Flags;
+
+  //! Same defaults as ECFNManager: everything except (4, 3)
+  constexpr Flags defaultFlags{{true, true, true, true, true, true, true, true, true, true, true, false}};
+}
+
+/**
+ * \brief Calculates normalized ECFs for several values of beta in one pass.
+ *
+ * The pairwise dR^2 of the constituents are computed once by PairwiseDeltaR2, from which the
+ * angular factors of all betas are derived and stored interleaved (beta index fastest). All (N, order)
+ * are then evaluated in a single sweep per N that accumulates every beta at once. The results are
+ * identical to those of calcECFN called separately for each beta. At most ecfn::kMaxBetas non-negative
+ * betas are supported.
+ * Buffers are kept between calls; one instance should not be shared between threads.
+ */
+class ECFCalculator {
+public:
+  /**
+   * @param betas angular parameters
+   */
+  ECFCalculator(std::vector<double> const& betas);
+  ~ECFCalculator() {}
+
+  /**
+   * \brief Calculate the ECFNs of the constituents for all betas
+   * @param constituents particles with which to calculate the correlations
+   */
+  void calculate(std::vector<fastjet::PseudoJet> const& constituents);
+
+  /**
+   * \brief Result of the last calculation (0 if not calculated)
+   * @param iBeta index of beta in the constructor argument
+   * @param N     number of particles (1-4)
+   * @param order order of the angular factor (1-3)
+   */
+  double get(unsigned iBeta, int N, int order) const { return results_[ecfn::slot(iBeta, N, order)]; }
+  //! All results of the last calculation, indexed by ecfn::slot
+  ecfn::Table const& results() const { return results_; }
+
+  unsigned nBetas() const { return betas_.size(); }
+
+  //! Enable or disable calculation for all orders of N
+  void setDoN(int N, bool b) { doN_[N - 1] = b; }
+  //! Enable or disable calculation of the given (N, order). N=1 and 2 are always calculated when enabled; (4, 3) is not implemented.
+  void setFlag(int N, int order, bool b) { flags_[ecfn::flagSlot(N, order)] = b; }
+  void setFlags(ecfn::Flags const& flags) { flags_ = flags; }
+
+private:
+  std::vector<double> betas_;
+  std::vector<double> halfBetas_;
+
+  bool doN_[ecfn::kMaxN]{true, true, true, true};
+  ecfn::Flags flags_{ecfn::defaultFlags};
+
+  ecfn::Table results_{};
+
+  // per-constituent and per-pair buffers
+  PairwiseDeltaR2 pairs_;
+  std::vector<double> angles_; //!< pow(dR2, beta/2) of pair p and beta b at p*nBetas + b
+  std::vector<double> sums_; //!< per-beta accumulators of the current N
+};
+
 /**
  * \brief Calculates normalized energy correlation functions
  * @param beta         angular parameter
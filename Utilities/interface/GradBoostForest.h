@@ -0,0 +1,55 @@
+#ifndef PANDAPROD_UTILITIES_GRADBOOSTFOREST_H
+#define PANDAPROD_UTILITIES_GRADBOOSTFOREST_H
+
+#include <string>
+#include <vector>
+
+namespace panda {
+
+  //! Flat evaluator for gradient-boosted TMVA BDTs (BoostType=Grad)
+  /*!
+   * Reads the trees of a TMVA weights XML file into contiguous arrays. Every tree is stored as a complete
+   * binary tree of the maximum depth of the forest: leaves above that depth are padded with dummy cuts that
+   * lead to copies of the same response. A jet is thus evaluated with the same number of steps in every
+   * tree, without pointer chasing, and a batch of jets can be walked through one tree at a time.
+   * The output reproduces TMVA::Reader::EvaluateMVA: cuts and responses are held in single precision as in
+   * TMVA::DecisionTreeNode, the responses are summed in tree order in double precision, and the sum is
+   * mapped to [-1, 1] by 2 / (1 + exp(-2 sum)) - 1. Inputs with a NaN give -999.
+   * Only variable transformations "None" and cuts on single variables (no Fisher cuts) are supported.
+   */
+  class GradBoostForest {
+  public:
+    GradBoostForest() {}
+    //! Load the forest from a TMVA weights file. Throws std::runtime_error on unsupported content.
+    GradBoostForest(std::string const& weightFile) { load(weightFile); }
+
+    void load(std::string const& weightFile);
+
+    bool empty() const { return nTrees_ == 0; }
+    unsigned nTrees() const { return nTrees_; }
+    unsigned depth() const { return depth_; }
+    //! Input variables (Expression attribute) in the order expected by evaluate
+    std::vector<std::string> const& variables() const { return variables_; }
+    unsigned nVariables() const { return variables_.size(); }
+
+    //! Evaluate one set of inputs (nVariables() values)
+    double evaluate(float const* inputs) const;
+    //! Evaluate nEvents sets of inputs stored back to back (nVariables() values each)
+    void evaluate(float const* inputs, unsigned nEvents, double* outputs) const;
+
+  private:
+    std::vector<std::string> variables_{};
+    unsigned nTrees_{0};
+    unsigned depth_{0};
+
+    //! Cut variable of internal node n of tree t at t * (2^depth - 1) + n. Node n has children 2n+1 and 2n+2.
+    std::vector<int> vars_{};
+    //! Cut values with the same layout as vars_. The second child is taken if input >= cut.
+    std::vector<float> cuts_{};
+    //! Responses of leaf l of tree t at t * 2^depth + l
+    std::vector<float> responses_{};
+  };
+
+}
+
+#endif
@@ -70,6 +70,8 @@ public:
   void set_pruning_rcut_factor(double rcut_factor) {_rcut_factor = rcut_factor;}
 
   void set_debug(bool debug) {_debug = debug;}
+  // evaluate the triplets of hard substructures concurrently (ignored unless FastJet is built with thread safety)
+  void set_parallel_triplets(bool parallel) {_parallel_triplets = parallel;}
   void set_qjets(double q_zcut, double q_dcut_fctr, double q_exp_min, double q_exp_max, double q_rigidity, double q_truncation_fctr) {
     _q_zcut = q_zcut; _q_dcut_fctr = q_dcut_fctr; _q_exp_min = q_exp_min; _q_exp_max = q_exp_max; _q_rigidity =  q_rigidity; _q_truncation_fctr =  q_truncation_fctr;
   }
@@ -140,6 +142,7 @@ private:
   //  CLHEP::HepRandomEngine* _rnEngine;
 
   bool _debug;
+  bool _parallel_triplets;
   
   bool _is_masscut_passed;
   bool _is_ptmincut_passed;
@@ -164,8 +167,20 @@ private:
   static bool _first_time;
   double _qweight;
   
+  // outcome of the filtering and reclustering of one triplet of hard substructures
+  struct TripletResult {
+    bool accepted;
+    PseudoJet triple;
+    PseudoJet topcandidate;
+    std::vector<PseudoJet> top_subs;
+    double deltatop;
+    double djsum;
+  };
+
   //internal functions
   void FindHardSubst(const PseudoJet& jet, std::vector<fastjet::PseudoJet>& t_parts);
+  // does not modify the tagger state; called concurrently when _parallel_triplets is set
+  void evaluate_triplet(const PseudoJet & triple, TripletResult & result);
   std::vector<PseudoJet> Filtering(const std::vector <PseudoJet> & top_constits, const JetDefinition & filtering_def);
   void store_topsubjets(const std::vector<PseudoJet>& top_subs);
   bool check_mass_criteria(const std::vector<fastjet::PseudoJet> & top_subs) const;
@@ -279,6 +294,7 @@ public:
   void set_pruning_rcut_factor(double rcut_factor) {_rcut_factor = rcut_factor;}
 
   void set_debug(bool debug) {_debug = debug;}
+  void set_parallel_triplets(bool parallel) {_parallel_triplets = parallel;}
   void do_qjets(bool qjets) {_do_qjets = qjets;}
   void set_qjets(double q_zcut, double q_dcut_fctr, double q_exp_min, double q_exp_max, double q_rigidity, double q_truncation_fctr) {
     _q_zcut = q_zcut; _q_dcut_fctr = q_dcut_fctr; _q_exp_min = q_exp_min; _q_exp_max = q_exp_max; _q_rigidity =  q_rigidity; _q_truncation_fctr =  q_truncation_fctr;
@@ -334,6 +350,7 @@ private:
   //  CLHEP::HepRandomEngine* _rnEngine;
   
   bool _debug;
+  bool _parallel_triplets;
   double _qweight;
 
   void UnclusterFatjets(const vector<fastjet::PseudoJet> & big_fatjets, vector<fastjet::PseudoJet> & small_fatjets, const ClusterSequence & cs, const double small_radius);
@@ -78,7 +78,8 @@ public:
     minM23Cut_(minM23Cut),
     minM13Cut_(minM13Cut),
     maxM13Cut_(maxM13Cut),
-    optRrejectMin_(optRrejectMin)//,
+    optRrejectMin_(optRrejectMin),
+    parallelTriplets_(false)//,
     //    engine_(0)
   {}
 
@@ -93,6 +94,15 @@ public:
 
   //  void set_rng(CLHEP::HepRandomEngine* engine){ engine_ = engine;}
 
+  /// evaluate the triplets of hard substructures concurrently. The triplets
+  /// share the ClusterSequence of the jet, so this requires a FastJet build
+  /// with thread safety; throws an Error otherwise. The result does not
+  /// depend on this setting.
+  void set_parallel_triplets(bool parallel);
+
+  /// whether FastJet was built with thread safety (set_parallel_triplets(true) is allowed)
+  static bool parallel_triplets_supported();
+
   // the type of the associated structure
   typedef HEPTopTaggerV2Structure StructureType;
 
@@ -130,6 +140,8 @@ private:
     bool optRrejectMin_; // set Ropt to zero for candidates that never leave the window around the initial mass
                          // otherwise (default) set them to R=0.5
 
+    bool parallelTriplets_; // evaluate the triplets concurrently
+
     // Random engine for Q-jet HTT
     //    CLHEP::HepRandomEngine* engine_;
 };
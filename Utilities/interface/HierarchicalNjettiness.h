@@ -0,0 +1,48 @@
+/**
+ * \file HierarchicalNjettiness.h
+ * \brief N-subjettiness for several N with a single seeding clustering
+ */
+#include "fastjet/PseudoJet.hh"
+#include "fastjet/JetDefinition.hh"
+#include "fastjet/contrib/Njettiness.hh"
+#include "fastjet/contrib/MeasureDefinition.hh"
+#include <vector>
+
+#ifndef HIERARCHICALNJETTINESS_H
+#define HIERARCHICALNJETTINESS_H
+
+/**
+ * \brief Computes tau_1 .. tau_maxN with one-pass kT axes, sharing the seeding clustering.
+ *
+ * Njettiness(OnePass_KT_Axes(), measure).getTau(N, inputs) clusters the inputs with the exclusive kT
+ * algorithm for every N to obtain the seed axes. Here the clustering is run once, the seeds of every N
+ * are read off its history, and each set is refined with the same one-pass minimization
+ * (OnePass_Manual_Axes). The results are identical to separate getTau calls.
+ * Not thread-safe (fastjet::contrib::Njettiness keeps the axes of the last call).
+ */
+class HierarchicalNjettiness {
+public:
+  /**
+   * @param measure N-subjettiness measure
+   * @param maxN    largest N to compute
+   */
+  HierarchicalNjettiness(fastjet::contrib::MeasureDefinition const& measure, int maxN);
+  ~HierarchicalNjettiness() {}
+
+  /**
+   * \brief Compute tau_N for N = 1 .. maxN
+   * @param inputs particles
+   * @param taus   output, tau_N at taus[N-1]
+   */
+  void getTaus(std::vector<fastjet::PseudoJet> const& inputs, double* taus);
+
+  int maxN() const { return maxN_; }
+
+private:
+  int maxN_;
+  //! same definition as fastjet::contrib::KT_Axes
+  fastjet::JetDefinition seedDef_;
+  fastjet::contrib::Njettiness njettiness_;
+};
+
+#endif
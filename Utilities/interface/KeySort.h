@@ -0,0 +1,39 @@
+#ifndef PANDAPROD_UTILITIES_KEYSORT_H
+#define PANDAPROD_UTILITIES_KEYSORT_H
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace panda {
+
+  //! Stable sort of indices by integer keys
+  /*!
+   * Sets order to the permutation that sorts the keys in ascending order: order[i] is the index of the
+   * i-th smallest key, and equal keys keep their original order. Longer inputs are sorted with an LSD
+   * radix sort (one counting pass per byte, skipping the bytes that are the same in all keys), short
+   * inputs with std::stable_sort.
+   */
+  void keySort(std::vector<uint64_t> const& keys, std::vector<unsigned>& order);
+
+  //! Key that orders as the float value (finite values and infinities)
+  inline uint32_t
+  floatKey(float v)
+  {
+    uint32_t bits;
+    std::memcpy(&bits, &v, sizeof(bits));
+    return (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+  }
+
+  //! Key that orders as the double value (finite values and infinities)
+  inline uint64_t
+  doubleKey(double v)
+  {
+    uint64_t bits;
+    std::memcpy(&bits, &v, sizeof(bits));
+    return (bits & 0x8000000000000000ull) ? ~bits : (bits | 0x8000000000000000ull);
+  }
+
+}
+
+#endif
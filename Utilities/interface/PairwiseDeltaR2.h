@@ -0,0 +1,73 @@
+/**
+ * \file PairwiseDeltaR2.h
+ * \brief Batch computation of the dR^2 of all pairs in a set of particles
+ */
+#include "fastjet/PseudoJet.hh"
+#include <vector>
+
+#ifndef PAIRWISEDELTAR2_H
+#define PAIRWISEDELTAR2_H
+
+/**
+ * \brief Caches pT, eta, and phi of a set of particles as structure-of-arrays and computes the dR^2 of all pairs.
+ *
+ * The dR^2 values are stored in a flat lower-triangular buffer, row by row. Each row is computed by a
+ * branch-free loop over contiguous eta and phi arrays that the compiler can vectorize. The values are
+ * identical to DeltaR2 (including its single precision).
+ */
+class PairwiseDeltaR2 {
+public:
+  PairwiseDeltaR2() {}
+  ~PairwiseDeltaR2() {}
+
+  /**
+   * \brief Cache the kinematics of the particles and compute all pairwise dR^2
+   * @param particles input particles
+   */
+  void fill(std::vector<fastjet::PseudoJet> const& particles);
+
+  /**
+   * \brief Compute pow(dR^2, halfBeta) of all pairs for several exponents at once
+   * @param halfBetas exponents (beta/2)
+   * @param nBetas    number of exponents
+   * @param angles    output, value of pair p and exponent b at p*nBetas + b
+   */
+  void fillPow(double const* halfBetas, unsigned nBetas, std::vector<double>& angles) const;
+
+  /**
+   * \brief dR^2 of a single pair, in single precision with phi wrapped to [-pi, pi]
+   */
+  static double compute(double eta1, double phi1, double eta2, double phi2) {
+    float dEta = eta1 - eta2;
+    float dPhi = phi1 - phi2;
+    double shift = dPhi < -kPi ? 2 * kPi : (dPhi > kPi ? -2 * kPi : 0.);
+    dPhi = shift + dPhi;
+    return dEta * dEta + dPhi * dPhi;
+  }
+
+  //! Index of the pair (i, j), j < i
+  static unsigned index(unsigned i, unsigned j) { return i * (i - 1) / 2 + j; }
+
+  unsigned size() const { return pTs_.size(); }
+  unsigned nPairs() const { return dR2s_.size(); }
+
+  //! dR^2 of the pair (i, j), j < i
+  double operator()(unsigned i, unsigned j) const { return dR2s_[index(i, j)]; }
+
+  double const* pTs() const { return pTs_.data(); }
+  double const* etas() const { return etas_.data(); }
+  double const* phis() const { return phis_.data(); }
+  //! All dR^2, indexed by index(i, j)
+  double const* dR2s() const { return dR2s_.data(); }
+
+private:
+  //! same value as used by the ECF code
+  static constexpr double kPi = 3.141592654;
+
+  std::vector<double> pTs_;
+  std::vector<double> etas_;
+  std::vector<double> phis_;
+  std::vector<double> dR2s_;
+};
+
+#endif
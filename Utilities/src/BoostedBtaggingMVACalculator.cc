@@ -1,20 +1,54 @@
 #include "../interface/BoostedBtaggingMVACalculator.h"
-#include "TMVA/Reader.h"
 #include <iostream>
 #include <cmath>
+#include <algorithm>
+#include <vector>
+#include <stdexcept>
 
 using namespace panda;
 
+constexpr unsigned BoostedBtaggingMVACalculator::kNVariables;
+
+char const* const BoostedBtaggingMVACalculator::variableNames[kNVariables] = {
+  "SubJet_csv",
+  "z_ratio",
+  "trackSipdSig_3",
+  "trackSipdSig_2",
+  "trackSipdSig_1",
+  "trackSipdSig_0",
+  "trackSipdSig_1_0",
+  "trackSipdSig_0_0",
+  "trackSipdSig_1_1",
+  "trackSipdSig_0_1",
+  "trackSip2dSigAboveCharm_0",
+  "trackSip2dSigAboveBottom_0",
+  "trackSip2dSigAboveBottom_1",
+  "tau0_trackEtaRel_0",
+  "tau0_trackEtaRel_1",
+  "tau0_trackEtaRel_2",
+  "tau1_trackEtaRel_0",
+  "tau1_trackEtaRel_1",
+  "tau1_trackEtaRel_2",
+  "tau_vertexMass_0",
+  "tau_vertexEnergyRatio_0",
+  "tau_vertexDeltaR_0",
+  "tau_flightDistance2dSig_0",
+  "tau_vertexMass_1",
+  "tau_vertexEnergyRatio_1",
+  "tau_flightDistance2dSig_1",
+  "jetNTracks",
+  "nSV"
+};
+
 //--------------------------------------------------------------------------------------------------
 BoostedBtaggingMVACalculator::BoostedBtaggingMVACalculator():
   fIsInitialized(false),
-  fReader(0),
+  fForest(),
   fMethodTag("")
 {}
 
 //--------------------------------------------------------------------------------------------------
 BoostedBtaggingMVACalculator::~BoostedBtaggingMVACalculator() {
-  delete fReader;
   fIsInitialized = false;
 }
 
@@ -22,51 +56,17 @@ BoostedBtaggingMVACalculator::~BoostedBtaggingMVACalculator() {
 void BoostedBtaggingMVACalculator::initialize(const std::string MethodTag, const std::string WeightFile)
 {
 	 fMethodTag	= MethodTag;
-	
+
 	if(WeightFile.length()>0) {
-		if(fReader !=0) delete fReader;
-		fReader = new TMVA::Reader();
-
-
-		fReader->AddVariable("SubJet_csv",&_SubJet_csv);
-		fReader->AddVariable("z_ratio",&_z_ratio);
-		fReader->AddVariable("trackSipdSig_3",&_trackSipdSig_3);
-		fReader->AddVariable("trackSipdSig_2",&_trackSipdSig_2);
-		fReader->AddVariable("trackSipdSig_1",&_trackSipdSig_1);
-		fReader->AddVariable("trackSipdSig_0",&_trackSipdSig_0);
-		fReader->AddVariable("trackSipdSig_1_0",&_trackSipdSig_1_0);
-		fReader->AddVariable("trackSipdSig_0_0",&_trackSipdSig_0_0);
-		fReader->AddVariable("trackSipdSig_1_1",&_trackSipdSig_1_1);
-		fReader->AddVariable("trackSipdSig_0_1",&_trackSipdSig_0_1);
-		fReader->AddVariable("trackSip2dSigAboveCharm_0",&_trackSip2dSigAboveCharm_0);
-		fReader->AddVariable("trackSip2dSigAboveBottom_0",&_trackSip2dSigAboveBottom_0);
-		fReader->AddVariable("trackSip2dSigAboveBottom_1",&_trackSip2dSigAboveBottom_1);
-		fReader->AddVariable("tau0_trackEtaRel_0",&_tau0_trackEtaRel_0);
-		fReader->AddVariable("tau0_trackEtaRel_1",&_tau0_trackEtaRel_1);
-		fReader->AddVariable("tau0_trackEtaRel_2",&_tau0_trackEtaRel_2);
-		fReader->AddVariable("tau1_trackEtaRel_0",&_tau1_trackEtaRel_0);
-		fReader->AddVariable("tau1_trackEtaRel_1",&_tau1_trackEtaRel_1);
-		fReader->AddVariable("tau1_trackEtaRel_2",&_tau1_trackEtaRel_2);
-		fReader->AddVariable("tau_vertexMass_0",&_tau_vertexMass_0);
-		fReader->AddVariable("tau_vertexEnergyRatio_0",&_tau_vertexEnergyRatio_0);
-		fReader->AddVariable("tau_vertexDeltaR_0",&_tau_vertexDeltaR_0);
-		fReader->AddVariable("tau_flightDistance2dSig_0",&_tau_flightDistance2dSig_0);
-		fReader->AddVariable("tau_vertexMass_1",&_tau_vertexMass_1);
-		fReader->AddVariable("tau_vertexEnergyRatio_1",&_tau_vertexEnergyRatio_1);
-		fReader->AddVariable("tau_flightDistance2dSig_1",&_tau_flightDistance2dSig_1);
-		fReader->AddVariable("jetNTracks",&_jetNTracks);
-		fReader->AddVariable("nSV",&_nSV);
-
-		fReader->AddSpectator("massPruned",&_massPruned);
-		fReader->AddSpectator("flavour",&_flavour);
-		fReader->AddSpectator("nbHadrons",&_nbHadrons);
-		fReader->AddSpectator("ptPruned",&_ptPruned);
-		fReader->AddSpectator("etaPruned",&_etaPruned);
-
-
-
-
-		fReader->BookMVA(fMethodTag, WeightFile);
+		fForest.load(WeightFile);
+
+		// the inputs are passed by position, as with TMVA::Reader::AddVariable
+		auto& variables(fForest.variables());
+		bool match(variables.size() == kNVariables);
+		for (unsigned iV(0); match && iV != kNVariables; ++iV)
+			match = (variables[iV] == variableNames[iV]);
+		if (!match)
+			throw std::runtime_error("BoostedBtaggingMVACalculator: input variables of " + WeightFile + " do not match");
 	}
 
 
@@ -83,61 +83,63 @@ float BoostedBtaggingMVACalculator::mvaValue(
 		const float tau1_trackEtaRel_0, const float tau1_trackEtaRel_1, const float tau1_trackEtaRel_2, const float tau_vertexMass_0,
 		const float tau_vertexEnergyRatio_0, const float tau_vertexDeltaR_0, const float tau_flightDistance2dSig_0, const float tau_vertexMass_1,
 		const float tau_vertexEnergyRatio_1, const float tau_flightDistance2dSig_1, const float jetNTracks, const float nSV,
-		const bool printDebug)
+		const bool printDebug) const
 {
-
-
-	_massPruned=massPruned;
-	_flavour=flavour;
-	_nbHadrons=nbHadrons;
-	_ptPruned=ptPruned;
-	_etaPruned=etaPruned;
-	_z_ratio=z_ratio;
-	_SubJet_csv = SubJet_csv;
-	_trackSipdSig_3=trackSipdSig_3;
-	_trackSipdSig_2=trackSipdSig_2;
-	_trackSipdSig_1=trackSipdSig_1;
-	_trackSipdSig_0=trackSipdSig_0;
-	_trackSipdSig_1_0=trackSipdSig_1_0;
-	_trackSipdSig_0_0=trackSipdSig_0_0;
-	_trackSipdSig_1_1=trackSipdSig_1_1;
-	_trackSipdSig_0_1=trackSipdSig_0_1;
-	_trackSip2dSigAboveCharm_0=trackSip2dSigAboveCharm_0;
-	_trackSip2dSigAboveBottom_0=trackSip2dSigAboveBottom_0;
-	_trackSip2dSigAboveBottom_1=trackSip2dSigAboveBottom_1;
-	_tau1_trackEtaRel_0=tau1_trackEtaRel_0;
-	_tau1_trackEtaRel_1=tau1_trackEtaRel_1;
-	_tau1_trackEtaRel_2=tau1_trackEtaRel_2;
-	_tau0_trackEtaRel_0=tau0_trackEtaRel_0;
-	_tau0_trackEtaRel_1=tau0_trackEtaRel_1;
-	_tau0_trackEtaRel_2=tau0_trackEtaRel_2;
-	_tau_vertexMass_0=tau_vertexMass_0;
-	_tau_vertexEnergyRatio_0=tau_vertexEnergyRatio_0;
-	_tau_vertexDeltaR_0=tau_vertexDeltaR_0;
-	_tau_flightDistance2dSig_0=tau_flightDistance2dSig_0;
-	_tau_vertexMass_1=tau_vertexMass_1;
-	_tau_vertexEnergyRatio_1=tau_vertexEnergyRatio_1;
-	_tau_flightDistance2dSig_1=tau_flightDistance2dSig_1;
-	_jetNTracks=jetNTracks;
-	_nSV=nSV;
-
-
-
-	double val = -2;
-	val = (fReader  ? fReader->EvaluateMVA(fMethodTag)   : -2); 
+	float const inputs[kNVariables] = {
+		SubJet_csv,
+		z_ratio,
+		trackSipdSig_3,
+		trackSipdSig_2,
+		trackSipdSig_1,
+		trackSipdSig_0,
+		trackSipdSig_1_0,
+		trackSipdSig_0_0,
+		trackSipdSig_1_1,
+		trackSipdSig_0_1,
+		trackSip2dSigAboveCharm_0,
+		trackSip2dSigAboveBottom_0,
+		trackSip2dSigAboveBottom_1,
+		tau0_trackEtaRel_0,
+		tau0_trackEtaRel_1,
+		tau0_trackEtaRel_2,
+		tau1_trackEtaRel_0,
+		tau1_trackEtaRel_1,
+		tau1_trackEtaRel_2,
+		tau_vertexMass_0,
+		tau_vertexEnergyRatio_0,
+		tau_vertexDeltaR_0,
+		tau_flightDistance2dSig_0,
+		tau_vertexMass_1,
+		tau_vertexEnergyRatio_1,
+		tau_flightDistance2dSig_1,
+		jetNTracks,
+		nSV
+	};
+
+	float val = -2;
+	mvaValues(inputs, 1, &val);
 
 	if(printDebug) {
 		std::cout << "[BoostedBtaggingMVACalculator]" << std::endl;
-		/*   std::cout << "Inputs: nvtx= " << _nvtx;
-		     std::cout << "  jetPt= " << _jetPt << "  jetEta= " << _jetEta << "  jetPhi= " << _jetPhi;
-		     std::cout << "  |d0|= " << _d0 << "  |dZ|= " << _dZ;
-		     std::cout << "  beta= " << _beta << "  betaStar= " << _betaStar;
-		     std::cout << "  nCharged= " << _nCharged << "  nNeutrals= " << nNeutrals;
-		     std::cout << "  dRMean= " << _dRMean << "  dR2Mean= " << _dR2Mean << "  ptD= " << _ptD;
-		     std::cout << "  frac01= " << _frac01 << "  frac02= " << _frac02 << "  frac03= " << _frac03 << "  frac04= " << _frac04 << "  frac05= " << _frac05;
-		     */  std::cout << std::endl;
+		std::cout << "Inputs:";
+		for (unsigned iV(0); iV != kNVariables; ++iV)
+			std::cout << " " << variableNames[iV] << "= " << inputs[iV];
+		std::cout << std::endl;
 		std::cout << " > MVA value = " << val << std::endl;
 	}
 
 	return val;
 }
+
+//--------------------------------------------------------------------------------------------------
+void BoostedBtaggingMVACalculator::mvaValues(float const* inputs, unsigned nJets, float* values) const
+{
+	if (fForest.empty()) {
+		std::fill(values, values + nJets, -2.);
+		return;
+	}
+
+	std::vector<double> outputs(nJets);
+	fForest.evaluate(inputs, nJets, outputs.data());
+	std::copy(outputs.begin(), outputs.end(), values);
+}
@@ -4,25 +4,42 @@
  * \author S.Narayanan
  */
 #include "../interface/EnergyCorrelations.h"
-#define PI 3.141592654
 
-double DeltaR2(fastjet::PseudoJet j1, fastjet::PseudoJet j2) {
-    float dEta2 = (j1.eta()-j2.eta()); dEta2 *= dEta2;
+#include <algorithm>
+#include <stdexcept>
 
-    float dPhi = j1.phi()-j2.phi();
-    if (dPhi<-PI)
-        dPhi = 2*PI+dPhi;
-    else if (dPhi>PI)
-        dPhi = -2*PI+dPhi;
+namespace {
+  /**
+   * \brief Finds the pairs with the smallest and the second smallest dR^2 among n pairs.
+   *
+   * pow(dR^2, beta/2) is monotonic in dR^2 for non-negative beta, so the same pairs give the
+   * smallest and second smallest angular factors for every beta.
+   */
+  inline void twoSmallest(double const* dR2s, unsigned int const* pairs, unsigned int n, unsigned int& p1, unsigned int& p2) {
+    unsigned int i1 = dR2s[1]<dR2s[0] ? 1 : 0;
+    unsigned int i2 = 1-i1;
+    for (unsigned int i=2; i!=n; ++i) {
+      if (dR2s[i]<dR2s[i1]) {
+        i2 = i1;
+        i1 = i;
+      }
+      else if (dR2s[i]<dR2s[i2])
+        i2 = i;
+    }
+    p1 = pairs[i1];
+    p2 = pairs[i2];
+  }
+}
 
-    return dEta2 + dPhi*dPhi;
+double DeltaR2(fastjet::PseudoJet const& j1, fastjet::PseudoJet const& j2) {
+  return PairwiseDeltaR2::compute(j1.eta(), j1.phi(), j2.eta(), j2.phi());
 }
 
 void calcECF(double beta, std::vector<fastjet::PseudoJet> &constituents, double *n1/*=0*/, double *n2/*=0*/, double *n3/*=0*/, double *n4/*=0*/) {
   unsigned int nC = constituents.size();
   double halfBeta = beta/2.;
 
-  // if only N=1,2, do not bother caching kinematics
+  // if only N=1,2, do not bother caching the pairwise dR^2; compute them inline from O(n) kinematics
   if (!n3 && !n4) {
     if (n1) { // N=1
       double val=0;
@@ -32,12 +49,16 @@ void calcECF(double beta, std::vector<fastjet::PseudoJet> &constituents, double
       *n1 = val;
     }
     if (n2) { // N=2
+      std::vector<double> pTs(nC), etas(nC), phis(nC);
+      for (unsigned int iC=0; iC!=nC; ++iC) {
+        pTs[iC] = constituents[iC].perp();
+        etas[iC] = constituents[iC].eta();
+        phis[iC] = constituents[iC].phi();
+      }
       double val=0;
       for (unsigned int iC=0; iC!=nC; ++iC) {
-        fastjet::PseudoJet iconst = constituents[iC];
         for (unsigned int jC=0; jC!=iC; ++jC) {
-          fastjet::PseudoJet jconst = constituents[jC];
-          val += iconst.perp() * jconst.perp() * pow(DeltaR2(iconst,jconst),halfBeta);
+          val += pTs[iC] * pTs[jC] * pow(PairwiseDeltaR2::compute(etas[iC],phis[iC],etas[jC],phis[jC]),halfBeta);
         }
       }
       *n2 = val;
@@ -46,20 +67,12 @@ void calcECF(double beta, std::vector<fastjet::PseudoJet> &constituents, double
   }
 
   // cache kinematics
-  std::vector<double> pTs(nC);
-  std::vector<std::vector<double>> dRs(nC);
-  for (unsigned int iC=0; iC!=nC; ++iC) {
-    dRs[iC].resize(iC);
-  }
-
-  for (unsigned int iC=0; iC!=nC; ++iC) {
-    fastjet::PseudoJet iconst = constituents[iC];
-    pTs[iC] = iconst.perp();
-    for (unsigned int jC=0; jC!=iC; ++jC) {
-      fastjet::PseudoJet jconst = constituents[jC];
-      dRs[iC][jC] = pow(DeltaR2(iconst,jconst),halfBeta);
-    }
-  }
+  PairwiseDeltaR2 pairs;
+  pairs.fill(constituents);
+  double const* pTs = pairs.pTs();
+  std::vector<double> angles;
+  pairs.fillPow(&halfBeta, 1, angles);
+  auto dR = [&angles](unsigned int iC, unsigned int jC) { return angles[PairwiseDeltaR2::index(iC,jC)]; };
   
   // now we calculate the real ECFs
   if (n1) { // N=1
@@ -73,7 +86,7 @@ void calcECF(double beta, std::vector<fastjet::PseudoJet> &constituents, double
     double val=0;
     for (unsigned int iC=0; iC!=nC; ++iC) {
       for (unsigned int jC=0; jC!=iC; ++jC) {
-        val += pTs[iC] * pTs[jC] * dRs[iC][jC]; 
+        val += pTs[iC] * pTs[jC] * dR(iC,jC); 
       } // jC
     } // iC
     *n2 = val;
@@ -82,9 +95,9 @@ void calcECF(double beta, std::vector<fastjet::PseudoJet> &constituents, double
     double val=0;
     for (unsigned int iC=0; iC!=nC; ++iC) {
       for (unsigned int jC=0; jC!=iC; ++jC) {
-        double val_ij = pTs[iC]*pTs[jC]*dRs[iC][jC];
+        double val_ij = pTs[iC]*pTs[jC]*dR(iC,jC);
         for (unsigned int kC=0; kC!=jC; ++kC) {
-          val += val_ij * pTs[kC] * dRs[iC][kC] * dRs[jC][kC];
+          val += val_ij * pTs[kC] * dR(iC,kC) * dR(jC,kC);
         } // kC
       } // jC
     } // iC
@@ -94,11 +107,11 @@ void calcECF(double beta, std::vector<fastjet::PseudoJet> &constituents, double
     double val=0;
     for (unsigned int iC=0; iC!=nC; ++iC) {
       for (unsigned int jC=0; jC!=iC; ++jC) {
-        double val_ij = pTs[iC]*pTs[jC]*dRs[iC][jC];
+        double val_ij = pTs[iC]*pTs[jC]*dR(iC,jC);
         for (unsigned int kC=0; kC!=jC; ++kC) {
-          double val_ijk = val_ij * pTs[kC] * dRs[iC][kC] * dRs[jC][kC];
+          double val_ijk = val_ij * pTs[kC] * dR(iC,kC) * dR(jC,kC);
           for (unsigned int lC=0; lC!=kC; ++lC) {
-            val += val_ijk * pTs[lC] * dRs[iC][lC] * dRs[jC][lC] * dRs[kC][lC];
+            val += val_ijk * pTs[lC] * dR(iC,lC) * dR(jC,lC) * dR(kC,lC);
           } // lC
         } // kC
       } // jC
@@ -108,156 +121,197 @@ void calcECF(double beta, std::vector<fastjet::PseudoJet> &constituents, double
 
 }
 
-/* TODO: switch from manual sort to std::partial_sort for readability*/
-void calcECFN(double beta, std::vector<fastjet::PseudoJet> &constituents, ECFNManager *manager, bool useMin/*=true*/) {
+ECFCalculator::ECFCalculator(std::vector<double> const& betas) :
+  betas_(betas),
+  halfBetas_(betas.size()),
+  sums_(betas.size() * ecfn::kMaxOrder, 0.)
+{
+  if (betas_.size() > ecfn::kMaxBetas)
+    throw std::runtime_error("ECFCalculator supports at most 4 betas");
+
+  for (unsigned int iB=0; iB!=betas_.size(); ++iB)
+    halfBetas_[iB] = betas_[iB]/2.;
+}
+
+void ECFCalculator::calculate(std::vector<fastjet::PseudoJet> const& constituents) {
   unsigned int nC = constituents.size();
-  double halfBeta = beta/2.;
+  unsigned int nB = betas_.size();
 
-  // get the normalization factor
-  double baseNorm=0; 
-  calcECF(beta,constituents,&baseNorm,0,0,0);
+  results_.fill(0.);
 
-  // cache kinematics
-  std::vector<double> pTs(nC);
-  std::vector<std::vector<double>> dRs(nC);
-  for (unsigned int iC=0; iC!=nC; ++iC) {
-    dRs[iC].resize(iC);
-  }
+  // cache kinematics; the normalization is the N=1 ECF
+  pairs_.fill(constituents);
+  pairs_.fillPow(halfBetas_.data(), nB, angles_);
+  double const* pTs = pairs_.pTs();
+  double const* allDR2s = pairs_.dR2s();
+
+  double baseNorm=0;
+  for (unsigned int iC=0; iC!=nC; ++iC)
+    baseNorm += pTs[iC];
 
-  for (unsigned int iC=0; iC!=nC; ++iC) {
-    fastjet::PseudoJet iconst = constituents[iC];
-    pTs[iC] = iconst.perp();
-    for (unsigned int jC=0; jC!=iC; ++jC) {
-      fastjet::PseudoJet jconst = constituents[jC];
-      dRs[iC][jC] = pow(DeltaR2(iconst,jconst),halfBeta);
+  double* sums = sums_.data();
+  auto result = [this](unsigned int iB, int N, int order)->double& {
+    return results_[ecfn::slot(iB,N,order)];
+  };
+
+  if (doN_[0]) { // N=1
+    for (unsigned int iB=0; iB!=nB; ++iB) {
+      for (int order=1; order!=4; ++order)
+        result(iB,1,order) = 1;
     }
   }
-  
-  // now we calculate the ECFNs
-  if (manager->doN1) { // N=1
-    manager->ecfns["1_1"] = 1;
-    manager->ecfns["1_2"] = 1;
-    manager->ecfns["1_3"] = 1;
-  }
-  if (manager->doN2) { // N=2
-    double norm = pow(baseNorm,2);
-    double val=0;
+
+  if (doN_[1]) { // N=2
+    std::fill(sums_.begin(), sums_.end(), 0.);
     for (unsigned int iC=0; iC!=nC; ++iC) {
       for (unsigned int jC=0; jC!=iC; ++jC) {
-        val += pTs[iC] * pTs[jC] * dRs[iC][jC]; 
+        double val_ij = pTs[iC]*pTs[jC];
+        double const* angles = &angles_[PairwiseDeltaR2::index(iC,jC)*nB];
+        for (unsigned int iB=0; iB!=nB; ++iB)
+          sums[iB] += val_ij * angles[iB];
       } // jC
     } // iC
-    val /= norm;
-    manager->ecfns["2_1"] = val;
-    manager->ecfns["2_2"] = val;
-    manager->ecfns["2_3"] = val;
+    double norm = pow(baseNorm,2);
+    for (unsigned int iB=0; iB!=nB; ++iB) {
+      double val = sums[iB]/norm;
+      for (int order=1; order!=4; ++order)
+        result(iB,2,order) = val;
+    }
   }
 
-  bool doI1=manager->flags["3_1"];
-  bool doI2=manager->flags["3_2"];
-  bool doI3=manager->flags["3_3"];
-  if (manager->doN3 && (doI1||doI2||doI3)) {
-    double norm = pow(baseNorm,3);
-    double val1=0,val2=0,val3=0;
-    unsigned int nAngles=3;
-    std::vector<double> angles(nAngles);
+  bool doI1=flags_[ecfn::flagSlot(3,1)];
+  bool doI2=flags_[ecfn::flagSlot(3,2)];
+  bool doI3=flags_[ecfn::flagSlot(3,3)];
+  if (doN_[2] && (doI1||doI2||doI3)) { // N=3
+    std::fill(sums_.begin(), sums_.end(), 0.);
+    double dR2s[3];
+    unsigned int pairs[3];
+    unsigned int p1, p2;
 
     for (unsigned int iC=0; iC!=nC; ++iC) {
       for (unsigned int jC=0; jC!=iC; ++jC) {
         double val_ij = pTs[iC]*pTs[jC];
-        angles[0] = dRs[iC][jC];
+        pairs[0] = PairwiseDeltaR2::index(iC,jC);
+        dR2s[0] = allDR2s[pairs[0]];
+        double const* angles0 = &angles_[pairs[0]*nB];
 
         for (unsigned int kC=0; kC!=jC; ++kC) {
-          angles[1] = dRs[iC][kC];
-          angles[2] = dRs[jC][kC];
+          double val_ijk = val_ij * pTs[kC];
+          pairs[1] = PairwiseDeltaR2::index(iC,kC);
+          pairs[2] = PairwiseDeltaR2::index(jC,kC);
+          dR2s[1] = allDR2s[pairs[1]];
+          dR2s[2] = allDR2s[pairs[2]];
+          twoSmallest(dR2s, pairs, 3, p1, p2);
 
-          if (doI1||doI2||doI3) {
-            double angle_1=999; unsigned int index_1=999;
-            for (unsigned int iA=0; iA!=nAngles; ++iA) {
-              if (angles[iA]<angle_1) {
-                angle_1 = angles[iA];
-                index_1 = iA;
-              }
-            }
-            if (doI2||doI3) {
-              double angle_2=999; 
-              for (unsigned int jA=0; jA!=nAngles; ++jA) {
-                if (jA==index_1) continue;
-                if (angles[jA]<angle_2) {
-                  angle_2 = angles[jA];
-                }
-              }
-              if (doI3) {
-                val3 += val_ij * pTs[kC] * angles[0] * angles[1] * angles[2];
-              }
-              if (doI2)
-                val2 += val_ij * pTs[kC] * angle_1 * angle_2;
-            }
+          double const* angles1 = &angles_[pairs[1]*nB];
+          double const* angles2 = &angles_[pairs[2]*nB];
+          double const* min1 = &angles_[p1*nB];
+          double const* min2 = &angles_[p2*nB];
+
+          for (unsigned int iB=0; iB!=nB; ++iB) {
+            // calcECFN starts the minimum search from 999
+            double angle_1 = min1[iB]<999 ? min1[iB] : 999;
+            double angle_2 = min2[iB]<999 ? min2[iB] : 999;
+            double* s = sums + iB*3;
             if (doI1)
-              val1 += val_ij * pTs[kC] * angle_1;
+              s[0] += val_ijk * angle_1;
+            if (doI2)
+              s[1] += val_ijk * angle_1 * angle_2;
+            if (doI3)
+              s[2] += val_ijk * angles0[iB] * angles1[iB] * angles2[iB];
           }
-
         } // kC
       } // jC
     } // iC
-    val1 /= norm; val2 /= norm; val3 /= norm;
-    manager->ecfns["3_1"] = val1;
-    manager->ecfns["3_2"] = val2;
-    manager->ecfns["3_3"] = val3;
+    double norm = pow(baseNorm,3);
+    for (unsigned int iB=0; iB!=nB; ++iB) {
+      for (int order=1; order!=4; ++order)
+        result(iB,3,order) = sums[iB*3 + order-1]/norm;
+    }
   }
 
-  doI1=manager->flags["4_1"];
-  doI2=manager->flags["4_2"];
-  if (manager->doN4 && (doI1||doI2)) {
-    double norm = pow(baseNorm,4);
-    double val1=0,val2=0;
-    unsigned int nAngles=6;
-    std::vector<double> angles(nAngles);
+  doI1=flags_[ecfn::flagSlot(4,1)];
+  doI2=flags_[ecfn::flagSlot(4,2)];
+  if (doN_[3] && (doI1||doI2)) { // N=4
+    std::fill(sums_.begin(), sums_.end(), 0.);
+    double dR2s[6];
+    unsigned int pairs[6];
+    unsigned int p1, p2;
 
     for (unsigned int iC=0; iC!=nC; ++iC) {
       for (unsigned int jC=0; jC!=iC; ++jC) {
         double val_ij = pTs[iC]*pTs[jC];
-        angles[0] = dRs[iC][jC];
+        pairs[0] = PairwiseDeltaR2::index(iC,jC);
+        dR2s[0] = allDR2s[pairs[0]];
 
         for (unsigned int kC=0; kC!=jC; ++kC) {
           double val_ijk = val_ij * pTs[kC];
-          angles[1] = dRs[iC][kC];
-          angles[2] = dRs[jC][kC];
+          pairs[1] = PairwiseDeltaR2::index(iC,kC);
+          pairs[2] = PairwiseDeltaR2::index(jC,kC);
+          dR2s[1] = allDR2s[pairs[1]];
+          dR2s[2] = allDR2s[pairs[2]];
 
           for (unsigned int lC=0; lC!=kC; ++lC) {
-            angles[3] = dRs[iC][lC];
-            angles[4] = dRs[jC][lC];
-            angles[5] = dRs[kC][lC];
+            double val_ijkl = val_ijk * pTs[lC];
+            pairs[3] = PairwiseDeltaR2::index(iC,lC);
+            pairs[4] = PairwiseDeltaR2::index(jC,lC);
+            pairs[5] = PairwiseDeltaR2::index(kC,lC);
+            dR2s[3] = allDR2s[pairs[3]];
+            dR2s[4] = allDR2s[pairs[4]];
+            dR2s[5] = allDR2s[pairs[5]];
+            twoSmallest(dR2s, pairs, 6, p1, p2);
+
+            double const* min1 = &angles_[p1*nB];
+            double const* min2 = &angles_[p2*nB];
 
-            if (doI1||doI2) {
-              double angle_1=999; unsigned int index_1=999;
-              for (unsigned int iA=0; iA!=nAngles; ++iA) {
-                if (angles[iA]<angle_1) {
-                  angle_1 = angles[iA];
-                  index_1 = iA;
-                }
-              }
-              if (doI2) {
-                double angle_2=999; 
-                for (unsigned int jA=0; jA!=nAngles; ++jA) {
-                  if (jA==index_1) continue;
-                  if (angles[jA]<angle_2) {
-                    angle_2 = angles[jA];
-                  }
-                }
-                val2 += val_ijk * pTs[lC] * angle_1 * angle_2;
-              }
+            for (unsigned int iB=0; iB!=nB; ++iB) {
+              double angle_1 = min1[iB]<999 ? min1[iB] : 999;
+              double angle_2 = min2[iB]<999 ? min2[iB] : 999;
+              double* s = sums + iB*3;
               if (doI1)
-                val1 += val_ijk * pTs[lC] * angle_1;
+                s[0] += val_ijkl * angle_1;
+              if (doI2)
+                s[1] += val_ijkl * angle_1 * angle_2;
             }
           } // lC
         } // kC
       } // jC
     } // iC
-    val1 /= norm; val2 /= norm;
-    manager->ecfns["4_1"] = val1;
-    manager->ecfns["4_2"] = val2;
-    manager->ecfns["4_3"] = 0;
+    double norm = pow(baseNorm,4);
+    for (unsigned int iB=0; iB!=nB; ++iB) {
+      result(iB,4,1) = sums[iB*3]/norm;
+      result(iB,4,2) = sums[iB*3 + 1]/norm;
+    }
+  }
+}
+
+void calcECFN(double beta, std::vector<fastjet::PseudoJet> &constituents, ECFNManager *manager, bool useMin/*=true*/) {
+  // translate the string-keyed configuration to the fixed layout
+  bool doN[ecfn::kMaxN] = {manager->doN1, manager->doN2, manager->doN3, manager->doN4};
+  ecfn::Flags flags{ecfn::defaultFlags};
+  for (int N=3; N!=5; ++N) {
+    for (int order=1; order!=ecfn::kMaxOrder+1; ++order)
+      flags[ecfn::flagSlot(N,order)] = manager->flags[TString::Format("%i_%i",N,order)];
   }
 
+  ECFCalculator calculator({beta});
+  for (int N=1; N!=ecfn::kMaxN+1; ++N)
+    calculator.setDoN(N, doN[N-1]);
+  calculator.setFlags(flags);
+
+  calculator.calculate(constituents);
+
+  // keys are written only for the Ns that calcECFN always computed
+  bool filled[ecfn::kMaxN] = {
+    doN[0],
+    doN[1],
+    doN[2] && (flags[ecfn::flagSlot(3,1)] || flags[ecfn::flagSlot(3,2)] || flags[ecfn::flagSlot(3,3)]),
+    doN[3] && (flags[ecfn::flagSlot(4,1)] || flags[ecfn::flagSlot(4,2)])
+  };
+  for (int N=1; N!=ecfn::kMaxN+1; ++N) {
+    if (!filled[N-1])
+      continue;
+    for (int order=1; order!=ecfn::kMaxOrder+1; ++order)
+      manager->ecfns[TString::Format("%i_%i",N,order)] = calculator.get(0,N,order);
+  }
 }
@@ -0,0 +1,346 @@
+#include "../interface/GradBoostForest.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+
+using namespace panda;
+
+namespace {
+
+  //! One tag of the weights file, with the character data that follows it
+  struct Tag {
+    std::string name{};
+    std::map<std::string, std::string> attributes{};
+    bool closing{false};
+    bool selfClosing{false};
+    std::string text{};
+
+    std::string const& attr(char const* key) const {
+      auto itr(attributes.find(key));
+      if (itr == attributes.end())
+        throw std::runtime_error(std::string("GradBoostForest: attribute ") + key + " missing in <" + name + ">");
+      return itr->second;
+    }
+  };
+
+  std::string
+  unescape(std::string const& s)
+  {
+    static std::pair<char const*, char> const entities[] = {
+      {"&lt;", '<'}, {"&gt;", '>'}, {"&quot;", '"'}, {"&apos;", '\''}, {"&amp;", '&'}
+    };
+
+    std::string result;
+    for (unsigned pos(0); pos < s.size(); ++pos) {
+      char c(s[pos]);
+      if (c == '&') {
+        for (auto& ent : entities) {
+          if (s.compare(pos, std::char_traits<char>::length(ent.first), ent.first) == 0) {
+            c = ent.second;
+            pos += std::char_traits<char>::length(ent.first) - 1;
+            break;
+          }
+        }
+      }
+      result += c;
+    }
+    return result;
+  }
+
+  //! Minimal reader for the machine-written TMVA XML. Skips the declaration and comments.
+  class TagReader {
+  public:
+    TagReader(std::string const& content) : content_(content) {}
+
+    bool next(Tag& tag) {
+      while (true) {
+        size_t begin(content_.find('<', pos_));
+        if (begin == std::string::npos)
+          return false;
+
+        char const* terminator(">");
+        if (content_.compare(begin, 4, "<!--") == 0)
+          terminator = "-->";
+        else if (content_.compare(begin, 2, "<?") == 0)
+          terminator = "?>";
+
+        size_t end(content_.find(terminator, begin));
+        if (end == std::string::npos)
+          throw std::runtime_error("GradBoostForest: unterminated tag");
+
+        pos_ = end + std::char_traits<char>::length(terminator);
+
+        if (terminator[0] == '>')
+          return parse_(content_.substr(begin + 1, end - begin - 1), tag);
+      }
+    }
+
+  private:
+    bool parse_(std::string inner, Tag& tag) {
+      tag = Tag();
+
+      if (!inner.empty() && inner[0] == '/') {
+        tag.closing = true;
+        inner.erase(0, 1);
+      }
+      if (!inner.empty() && inner.back() == '/') {
+        tag.selfClosing = true;
+        inner.pop_back();
+      }
+
+      size_t pos(inner.find_first_of(" \t\r\n"));
+      tag.name = inner.substr(0, pos);
+
+      while (pos < inner.size()) {
+        size_t eq(inner.find('=', pos));
+        if (eq == std::string::npos)
+          break;
+        size_t keyBegin(inner.find_first_not_of(" \t\r\n", pos));
+        size_t keyEnd(inner.find_last_not_of(" \t\r\n", eq - 1) + 1);
+        size_t valueBegin(inner.find_first_of("\"'", eq));
+        if (valueBegin == std::string::npos)
+          throw std::runtime_error("GradBoostForest: malformed attribute in <" + tag.name + ">");
+        size_t valueEnd(inner.find(inner[valueBegin], valueBegin + 1));
+        if (valueEnd == std::string::npos)
+          throw std::runtime_error("GradBoostForest: malformed attribute in <" + tag.name + ">");
+
+        tag.attributes[inner.substr(keyBegin, keyEnd - keyBegin)] = unescape(inner.substr(valueBegin + 1, valueEnd - valueBegin - 1));
+        pos = valueEnd + 1;
+      }
+
+      size_t textEnd(content_.find('<', pos_));
+      tag.text = content_.substr(pos_, textEnd == std::string::npos ? std::string::npos : textEnd - pos_);
+
+      return true;
+    }
+
+    std::string const& content_;
+    size_t pos_{0};
+  };
+
+  //! Node of a tree as read from the file
+  struct Node {
+    int var{-1};
+    float cut{0.};
+    bool cutType{true};
+    bool leaf{true};
+    float response{0.};
+    int children[2]{-1, -1}; // left, right
+  };
+
+  unsigned
+  treeDepth(std::vector<Node> const& nodes, int iNode)
+  {
+    auto& node(nodes[iNode]);
+    if (node.leaf)
+      return 0;
+    return 1 + std::max(treeDepth(nodes, node.children[0]), treeDepth(nodes, node.children[1]));
+  }
+
+  //! Write the subtree of nodes[iNode] into the complete tree at heap index iHeap
+  void
+  flatten(std::vector<Node> const& nodes, int iNode, unsigned iHeap, unsigned level, unsigned depth, int* vars, float* cuts, float* responses)
+  {
+    auto& node(nodes[iNode]);
+
+    if (level == depth) {
+      responses[iHeap - ((1u << depth) - 1)] = node.response;
+      return;
+    }
+
+    int first(iNode);
+    int second(iNode);
+    if (node.leaf) {
+      // padding: both branches end in the same response
+      vars[iHeap] = 0;
+      cuts[iHeap] = 0.;
+    }
+    else {
+      vars[iHeap] = node.var;
+      cuts[iHeap] = node.cut;
+      // TMVA goes right if (input >= cut) == cutType
+      first = node.children[node.cutType ? 0 : 1];
+      second = node.children[node.cutType ? 1 : 0];
+    }
+
+    flatten(nodes, first, 2 * iHeap + 1, level + 1, depth, vars, cuts, responses);
+    flatten(nodes, second, 2 * iHeap + 2, level + 1, depth, vars, cuts, responses);
+  }
+
+}
+
+void
+GradBoostForest::load(std::string const& _weightFile)
+{
+  std::ifstream source(_weightFile);
+  if (!source.is_open())
+    throw std::runtime_error("GradBoostForest: cannot open " + _weightFile);
+
+  std::stringstream buffer;
+  buffer << source.rdbuf();
+  std::string content(buffer.str());
+
+  variables_.clear();
+  nTrees_ = 0;
+  depth_ = 0;
+
+  std::vector<std::vector<Node>> trees;
+  std::vector<int> stack;
+  unsigned nTreesDeclared(0);
+  bool inTree(false);
+
+  TagReader reader(content);
+  Tag tag;
+  while (reader.next(tag)) {
+    if (tag.closing) {
+      if (tag.name == "Node") {
+        if (stack.empty())
+          throw std::runtime_error("GradBoostForest: unbalanced </Node> in " + _weightFile);
+        stack.pop_back();
+      }
+      else if (tag.name == "BinaryTree")
+        inTree = false;
+
+      continue;
+    }
+
+    if (tag.name == "MethodSetup") {
+      if (tag.attr("Method").compare(0, 3, "BDT") != 0)
+        throw std::runtime_error("GradBoostForest: " + _weightFile + " is not a BDT");
+    }
+    else if (tag.name == "Option") {
+      if (tag.attr("name") == "BoostType" && tag.text != "Grad")
+        throw std::runtime_error("GradBoostForest: BoostType " + tag.text + " of " + _weightFile + " is not supported");
+    }
+    else if (tag.name == "Variable") {
+      unsigned index(std::atoi(tag.attr("VarIndex").c_str()));
+      if (index >= variables_.size())
+        variables_.resize(index + 1);
+      variables_[index] = tag.attr("Expression");
+    }
+    else if (tag.name == "Transformations") {
+      if (std::atoi(tag.attr("NTransformations").c_str()) != 0)
+        throw std::runtime_error("GradBoostForest: variable transformations of " + _weightFile + " are not supported");
+    }
+    else if (tag.name == "Weights") {
+      nTreesDeclared = std::atoi(tag.attr("NTrees").c_str());
+    }
+    else if (tag.name == "BinaryTree") {
+      trees.emplace_back();
+      inTree = true;
+      stack.clear();
+    }
+    else if (tag.name == "Node") {
+      if (!inTree)
+        throw std::runtime_error("GradBoostForest: <Node> outside of a tree in " + _weightFile);
+
+      if (std::atoi(tag.attr("NCoef").c_str()) != 0)
+        throw std::runtime_error("GradBoostForest: Fisher cuts of " + _weightFile + " are not supported");
+
+      auto& nodes(trees.back());
+      int iNode(nodes.size());
+      nodes.emplace_back();
+      auto& node(nodes.back());
+
+      // single precision as in TMVA::DecisionTreeNode
+      node.var = std::atoi(tag.attr("IVar").c_str());
+      node.cut = std::strtof(tag.attr("Cut").c_str(), 0);
+      node.cutType = std::atoi(tag.attr("cType").c_str()) != 0;
+      node.leaf = std::atoi(tag.attr("nType").c_str()) != 0;
+      node.response = std::strtof(tag.attr("res").c_str(), 0);
+
+      if (stack.empty()) {
+        if (iNode != 0)
+          throw std::runtime_error("GradBoostForest: more than one root node in a tree of " + _weightFile);
+      }
+      else {
+        auto& pos(tag.attr("pos"));
+        if (pos != "l" && pos != "r")
+          throw std::runtime_error("GradBoostForest: invalid node position " + pos + " in " + _weightFile);
+        nodes[stack.back()].children[pos == "l" ? 0 : 1] = iNode;
+      }
+
+      if (!tag.selfClosing)
+        stack.push_back(iNode);
+    }
+  }
+
+  if (trees.empty() || trees.size() != nTreesDeclared)
+    throw std::runtime_error("GradBoostForest: could not read the trees of " + _weightFile);
+
+  for (auto& nodes : trees) {
+    if (nodes.empty())
+      throw std::runtime_error("GradBoostForest: empty tree in " + _weightFile);
+
+    for (auto& node : nodes) {
+      if (node.leaf)
+        continue;
+      if (node.children[0] < 0 || node.children[1] < 0)
+        throw std::runtime_error("GradBoostForest: incomplete node in " + _weightFile);
+      if (node.var < 0 || node.var >= int(variables_.size()))
+        throw std::runtime_error("GradBoostForest: invalid cut variable in " + _weightFile);
+    }
+
+    depth_ = std::max(depth_, treeDepth(nodes, 0));
+  }
+
+  // padding doubles the size with every level
+  if (depth_ > 16)
+    throw std::runtime_error("GradBoostForest: trees of " + _weightFile + " are too deep");
+
+  nTrees_ = trees.size();
+
+  unsigned nNodes((1u << depth_) - 1);
+  vars_.assign(nTrees_ * nNodes, 0);
+  cuts_.assign(nTrees_ * nNodes, 0.);
+  responses_.assign(nTrees_ * (nNodes + 1), 0.);
+
+  for (unsigned iT(0); iT != nTrees_; ++iT)
+    flatten(trees[iT], 0, 0, 0, depth_, vars_.data() + iT * nNodes, cuts_.data() + iT * nNodes, responses_.data() + iT * (nNodes + 1));
+}
+
+double
+GradBoostForest::evaluate(float const* _inputs) const
+{
+  double output;
+  evaluate(_inputs, 1, &output);
+  return output;
+}
+
+void
+GradBoostForest::evaluate(float const* _inputs, unsigned _nEvents, double* _outputs) const
+{
+  unsigned nVars(variables_.size());
+  unsigned nNodes((1u << depth_) - 1);
+
+  std::fill(_outputs, _outputs + _nEvents, 0.);
+
+  // trees in the outer loop: each tree is read once per batch, and the sums are accumulated in tree order as in TMVA
+  for (unsigned iT(0); iT != nTrees_; ++iT) {
+    int const* vars(vars_.data() + iT * nNodes);
+    float const* cuts(cuts_.data() + iT * nNodes);
+    float const* responses(responses_.data() + iT * (nNodes + 1));
+
+    for (unsigned iE(0); iE != _nEvents; ++iE) {
+      float const* x(_inputs + iE * nVars);
+      unsigned n(0);
+      for (unsigned d(0); d != depth_; ++d)
+        n = 2 * n + 1 + (x[vars[n]] >= cuts[n]);
+
+      _outputs[iE] += responses[n - nNodes];
+    }
+  }
+
+  for (unsigned iE(0); iE != _nEvents; ++iE) {
+    float const* x(_inputs + iE * nVars);
+    if (std::any_of(x, x + nVars, [](float v) { return std::isnan(v); }))
+      _outputs[iE] = -999.;
+    else
+      _outputs[iE] = 2. / (1. + std::exp(-2. * _outputs[iE])) - 1.;
+  }
+}
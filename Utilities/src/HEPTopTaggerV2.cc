@@ -1,5 +1,14 @@
 #include "../interface/HEPTopTaggerV2.h"
 
+#include "fastjet/config.h"
+
+// the triplets share the ClusterSequence of the fat jet; they can only be evaluated concurrently
+// if FastJet was built with thread safety
+#ifdef FASTJET_HAVE_THREAD_SAFETY
+#include "tbb/parallel_for.h"
+#include "tbb/blocked_range.h"
+#endif
+
 // Do not change next line, it's needed by the sed-code that makes the tagger CMSSW-compatible.
 namespace external {
 
@@ -141,7 +150,7 @@ HEPTopTaggerV2_fixed_R::HEPTopTaggerV2_fixed_R() : _do_qjets(0),
 					       _zcut(0.1), _rcut_factor(0.5),
                                                    _q_zcut(0.1), _q_dcut_fctr(0.5), _q_exp_min(0.), _q_exp_max(0.), _q_rigidity(0.1), _q_truncation_fctr(0.0),// _rnEngine(0),
 					       //_qjet_plugin(_q_zcut, _q_dcut_fctr, _q_exp_min, _q_exp_max, _q_rigidity, _q_truncation_fctr),
-					       _debug(false)
+					       _debug(false), _parallel_triplets(false)
 {
   _djsum = 0.;
   _delta_top = 1000000000000.0;
@@ -168,7 +177,7 @@ HEPTopTaggerV2_fixed_R::HEPTopTaggerV2_fixed_R(const fastjet::PseudoJet jet) : _
 									   _zcut(0.1), _rcut_factor(0.5),
 									   _q_zcut(0.1), _q_dcut_fctr(0.5), _q_exp_min(0.), _q_exp_max(0.), _q_rigidity(0.1), _q_truncation_fctr(0.0),
                                                                                _fat(jet),// _rnEngine(0),
-									   _debug(false)
+									   _debug(false), _parallel_triplets(false)
 {}
 
 HEPTopTaggerV2_fixed_R::HEPTopTaggerV2_fixed_R(const fastjet::PseudoJet jet, 
@@ -182,7 +191,7 @@ HEPTopTaggerV2_fixed_R::HEPTopTaggerV2_fixed_R(const fastjet::PseudoJet jet,
 									   _zcut(0.1), _rcut_factor(0.5),
 									   _q_zcut(0.1), _q_dcut_fctr(0.5), _q_exp_min(0.), _q_exp_max(0.), _q_rigidity(0.1), _q_truncation_fctr(0.0),
 									   _fat(jet),// _rnEngine(0),
-									   _debug(false)
+									   _debug(false), _parallel_triplets(false)
 {}
 
 void HEPTopTaggerV2_fixed_R::run() {
@@ -222,8 +231,13 @@ void HEPTopTaggerV2_fixed_R::run() {
   // Necessary so that two-step-filtering can use the leading-three.
   _top_parts=sorted_by_pt(_top_parts);
 
-  // loop over triples
   _top_parts = sorted_by_pt(_top_parts);
+
+  // collect the triples
+  // The filtered candidate is built from a subset of the constituents of the triple and therefore cannot
+  // be heavier than the triple itself; triples below the lower edge of the mass window are skipped
+  // before the filtering and reclustering.
+  std::vector<TripletResult> triplets;
   for (unsigned rr = 0; rr < _top_parts.size(); rr++) {
     for (unsigned ll = rr + 1; ll < _top_parts.size(); ll++) {
       for (unsigned kk = ll + 1; kk < _top_parts.size(); kk++) {
@@ -240,100 +254,144 @@ void HEPTopTaggerV2_fixed_R::run() {
 
       	//pick triple
 	PseudoJet triple = join(_top_parts[rr], _top_parts[ll], _top_parts[kk]);
-	
-	//filtering 
-	double filt_top_R 
-	  = std::min(_Rfilt, 0.5*sqrt(std::min(_top_parts[kk].squared_distance(_top_parts[ll]), 
-					       std::min(_top_parts[rr].squared_distance(_top_parts[ll]), 
-							_top_parts[kk].squared_distance(_top_parts[rr])))));
-	JetDefinition filtering_def(_jet_algorithm_filter, filt_top_R);
-	fastjet::Filter filter(filtering_def, fastjet::SelectorNHardest(_nfilt) * fastjet::SelectorPtMin(_minpt_subjet));
-	PseudoJet topcandidate = filter(triple);
-
-	//mass window cut
-  	if (topcandidate.m() < _mtmin || _mtmax < topcandidate.m()) continue;
-
-	// Sanity cut: can't recluster less than 3 objects into three subjets
-	if (topcandidate.pieces().size() < 3)
-	  continue;
-       
-	// Recluster to 3 subjets and apply mass plane cuts
-	JetDefinition reclustering(_jet_algorithm_recluster, 3.14);
-	ClusterSequence *  cs_top_sub = new ClusterSequence(topcandidate.constituents(), reclustering);
-        std::vector <PseudoJet> top_subs = sorted_by_pt(cs_top_sub->exclusive_jets(3));         
-	cs_top_sub->delete_self_when_unused();
-
-	// Require the third subjet to be above the pT threshold
-	if (top_subs[2].perp() < _minpt_subjet)
-	  continue;
 
-	// Modes with early 2d-massplane cuts
-	if (_mode == EARLY_MASSRATIO_SORT_MASS      && !check_mass_criteria(top_subs)) {continue;}
-	if (_mode == EARLY_MASSRATIO_SORT_MODDJADE  && !check_mass_criteria(top_subs)) {continue;}
-
-	//is this candidate better than the other? -> update
-	double deltatop = fabs(topcandidate.m() - _mtmass);
-	double djsum = djademod(top_subs[0], top_subs[1], topcandidate) 
-	  + djademod(top_subs[0], top_subs[2], topcandidate)
-	  + djademod(top_subs[1], top_subs[2], topcandidate);
-	bool better = false;
-
-	// Modes 0 and 1 sort by top mass
-	if ( (_mode == EARLY_MASSRATIO_SORT_MASS) 
-	     || (_mode == LATE_MASSRATIO_SORT_MASS)) {
-	  if (deltatop < _delta_top) 
-	    better = true;
-	}
-	// Modes 2 and 3 sort by modified jade distance
-	else if ( (_mode == EARLY_MASSRATIO_SORT_MODDJADE) 
-		  || (_mode == LATE_MASSRATIO_SORT_MODDJADE)) {
-	  if (djsum > _djsum) 
-	    better = true;
-	}
-	// Mode 4 is the two-step filtering. No sorting necessary as
-	// we just look at the triplet of highest pT objects after
-	// unclustering
-	else if (_mode == TWO_STEP_FILTER) {
-	  better = true;
-	} 
-	else {
-	  std::cout << "ERROR: UNKNOWN MODE (IN DISTANCE MEASURE SELECTION)" << std::endl;
-	  return;
-	}
+	// small margin against rounding in the mass of the filtered candidate
+	if (triple.m() * (1. + 1.e-6) < _mtmin)
+	  continue;
 
-	if (better) {
-	  _djsum = djsum;
-	  _delta_top = deltatop; 
-	  _is_maybe_top = true;
-	  _top_candidate = topcandidate;
-	  _top_subs = top_subs;
-	  store_topsubjets(top_subs);
-	  _top_hadrons = topcandidate.constituents();
-	  // Pruning
-	  double _Rprun = _initial_jet.validated_cluster_sequence()->jet_def().R(); 
-	  JetDefinition jet_def_prune(fastjet::cambridge_algorithm, _Rprun);
-	  fastjet::Pruner pruner(jet_def_prune, _zcut, _rcut_factor);
-	  PseudoJet prunedjet = pruner(triple);
-	  _pruned_mass = prunedjet.m();
-	  _unfiltered_mass = triple.m();
-	  
-	  //are all criteria fulfilled?
-	  _is_masscut_passed = false;
-	  if (check_mass_criteria(top_subs)) {
-	    _is_masscut_passed = true;
-	  }
-	  _is_ptmincut_passed = false;
-	  if (_top_candidate.pt() > _minpt_tag) {
-	    _is_ptmincut_passed = true;
-	  }
-	}//end better
+	triplets.push_back(TripletResult());
+	triplets.back().triple = triple;
       }//end kk
     }//end ll
   }//end rr
+
+  // filter and recluster the triples
+#ifdef FASTJET_HAVE_THREAD_SAFETY
+  if (_parallel_triplets && triplets.size() > 1) {
+    tbb::parallel_for(tbb::blocked_range<unsigned>(0, triplets.size()), [this, &triplets](tbb::blocked_range<unsigned> const& range) {
+	for (unsigned iT = range.begin(); iT != range.end(); ++iT)
+	  evaluate_triplet(triplets[iT].triple, triplets[iT]);
+      });
+  }
+  else
+#endif
+  {
+    for (auto& result : triplets)
+      evaluate_triplet(result.triple, result);
+  }
+
+  // pick the best candidate in the original order of the triples
+  TripletResult* best = 0;
+  for (auto& result : triplets) {
+    if (!result.accepted)
+      continue;
+
+    //is this candidate better than the other? -> update
+    bool better = false;
+
+    // Modes 0 and 1 sort by top mass
+    if ( (_mode == EARLY_MASSRATIO_SORT_MASS) 
+	 || (_mode == LATE_MASSRATIO_SORT_MASS)) {
+      if (result.deltatop < _delta_top) 
+	better = true;
+    }
+    // Modes 2 and 3 sort by modified jade distance
+    else if ( (_mode == EARLY_MASSRATIO_SORT_MODDJADE) 
+	      || (_mode == LATE_MASSRATIO_SORT_MODDJADE)) {
+      if (result.djsum > _djsum) 
+	better = true;
+    }
+    // Mode 4 is the two-step filtering. No sorting necessary as
+    // we just look at the triplet of highest pT objects after
+    // unclustering
+    else if (_mode == TWO_STEP_FILTER) {
+      better = true;
+    } 
+    else {
+      std::cout << "ERROR: UNKNOWN MODE (IN DISTANCE MEASURE SELECTION)" << std::endl;
+      return;
+    }
+
+    if (better) {
+      _djsum = result.djsum;
+      _delta_top = result.deltatop; 
+      best = &result;
+    }
+  }
+
+  if (!best)
+    return;
+
+  _is_maybe_top = true;
+  _top_candidate = best->topcandidate;
+  _top_subs = best->top_subs;
+  store_topsubjets(best->top_subs);
+  _top_hadrons = best->topcandidate.constituents();
+  // Pruning
+  double _Rprun = _initial_jet.validated_cluster_sequence()->jet_def().R(); 
+  JetDefinition jet_def_prune(fastjet::cambridge_algorithm, _Rprun);
+  fastjet::Pruner pruner(jet_def_prune, _zcut, _rcut_factor);
+  PseudoJet prunedjet = pruner(best->triple);
+  _pruned_mass = prunedjet.m();
+  _unfiltered_mass = best->triple.m();
+	  
+  //are all criteria fulfilled?
+  _is_masscut_passed = false;
+  if (check_mass_criteria(best->top_subs)) {
+    _is_masscut_passed = true;
+  }
+  _is_ptmincut_passed = false;
+  if (_top_candidate.pt() > _minpt_tag) {
+    _is_ptmincut_passed = true;
+  }
    
   return;
 }
 
+void HEPTopTaggerV2_fixed_R::evaluate_triplet(const PseudoJet & triple, TripletResult & result) {
+  result.accepted = false;
+
+  std::vector<PseudoJet> const& parts = triple.pieces();
+
+  //filtering 
+  double filt_top_R 
+    = std::min(_Rfilt, 0.5*sqrt(std::min(parts[2].squared_distance(parts[1]), 
+					 std::min(parts[0].squared_distance(parts[1]), 
+						  parts[2].squared_distance(parts[0])))));
+  JetDefinition filtering_def(_jet_algorithm_filter, filt_top_R);
+  fastjet::Filter filter(filtering_def, fastjet::SelectorNHardest(_nfilt) * fastjet::SelectorPtMin(_minpt_subjet));
+  PseudoJet topcandidate = filter(triple);
+
+  //mass window cut
+  if (topcandidate.m() < _mtmin || _mtmax < topcandidate.m()) return;
+
+  // Sanity cut: can't recluster less than 3 objects into three subjets
+  if (topcandidate.pieces().size() < 3)
+    return;
+       
+  // Recluster to 3 subjets and apply mass plane cuts
+  JetDefinition reclustering(_jet_algorithm_recluster, 3.14);
+  ClusterSequence *  cs_top_sub = new ClusterSequence(topcandidate.constituents(), reclustering);
+  std::vector <PseudoJet> top_subs = sorted_by_pt(cs_top_sub->exclusive_jets(3));         
+  cs_top_sub->delete_self_when_unused();
+
+  // Require the third subjet to be above the pT threshold
+  if (top_subs[2].perp() < _minpt_subjet)
+    return;
+
+  // Modes with early 2d-massplane cuts
+  if (_mode == EARLY_MASSRATIO_SORT_MASS      && !check_mass_criteria(top_subs)) {return;}
+  if (_mode == EARLY_MASSRATIO_SORT_MODDJADE  && !check_mass_criteria(top_subs)) {return;}
+
+  result.accepted = true;
+  result.topcandidate = topcandidate;
+  result.top_subs = top_subs;
+  result.deltatop = fabs(topcandidate.m() - _mtmass);
+  result.djsum = djademod(top_subs[0], top_subs[1], topcandidate) 
+    + djademod(top_subs[0], top_subs[2], topcandidate)
+    + djademod(top_subs[1], top_subs[2], topcandidate);
+}
+
 void HEPTopTaggerV2_fixed_R::get_info() const {  
   std::cout << "#--------------------------------------------------------------------------\n";
   std::cout << "#                          HEPTopTaggerV2 Result" << std::endl;
@@ -420,7 +478,7 @@ HEPTopTaggerV2::HEPTopTaggerV2() : _do_optimalR(0), _do_qjets(0),
                                _optimalR_mmin(150.), _optimalR_mmax(200.), _optimalR_fw(0.175), _R_opt_diff(0.3), _R_opt_reject_min(false),
 			       _R_filt_optimalR_pass(0.2), _N_filt_optimalR_pass(5), _R_filt_optimalR_fail(0.3), _N_filt_optimalR_fail(3),
                                    _q_zcut(0.1), _q_dcut_fctr(0.5), _q_exp_min(0.), _q_exp_max(0.), _q_rigidity(0.1), _q_truncation_fctr(0.0),// _rnEngine(0),
-			       _debug(false)
+			       _debug(false), _parallel_triplets(false)
 {}
 
 HEPTopTaggerV2::HEPTopTaggerV2(const fastjet::PseudoJet & jet 
@@ -438,7 +496,7 @@ HEPTopTaggerV2::HEPTopTaggerV2(const fastjet::PseudoJet & jet
 			       _R_filt_optimalR_pass(0.2), _N_filt_optimalR_pass(5), _R_filt_optimalR_fail(0.3), _N_filt_optimalR_fail(3),
 			       _q_zcut(0.1), _q_dcut_fctr(0.5), _q_exp_min(0.), _q_exp_max(0.), _q_rigidity(0.1), _q_truncation_fctr(0.0),
 			       _fat(jet),//_rnEngine(0),
-			       _debug(false)
+			       _debug(false), _parallel_triplets(false)
 {}
 
 HEPTopTaggerV2::HEPTopTaggerV2(const fastjet::PseudoJet & jet, 
@@ -457,7 +515,7 @@ HEPTopTaggerV2::HEPTopTaggerV2(const fastjet::PseudoJet & jet,
 			       _R_filt_optimalR_pass(0.2), _N_filt_optimalR_pass(5), _R_filt_optimalR_fail(0.3), _N_filt_optimalR_fail(3),
 			       _q_zcut(0.1), _q_dcut_fctr(0.5), _q_exp_min(0.), _q_exp_max(0.), _q_rigidity(0.1), _q_truncation_fctr(0.0),
 			       _fat(jet),// _rnEngine(0),
-			       _debug(false)
+			       _debug(false), _parallel_triplets(false)
 {}
 
 void HEPTopTaggerV2::run() {
@@ -486,6 +544,7 @@ void HEPTopTaggerV2::run() {
     htt.set_pruning_zcut(_zcut);
     htt.set_pruning_rcut_factor(_rcut_factor);
     htt.set_debug(_debug);
+    htt.set_parallel_triplets(_parallel_triplets);
     htt.set_qjets(_q_zcut, _q_dcut_fctr, _q_exp_min, _q_exp_max, _q_rigidity, _q_truncation_fctr);
     htt.run();
     
@@ -503,6 +562,11 @@ void HEPTopTaggerV2::run() {
   
     big_fatjets.push_back(_jet);
     _Ropt = 0;
+
+    // The fixed-R tagger result depends only on its input jet. Jets that are not split at a step
+    // are the same history entries as in the previous step, so their results are reused.
+    map<int,HEPTopTaggerV2_fixed_R> previous_htts;
+    map<int,HEPTopTaggerV2_fixed_R> current_htts;
     
     for (int R = maxR; R >= minR; R -= stepR) {
       UnclusterFatjets(big_fatjets, small_fatjets, *_seq, R / 10.);
@@ -515,6 +579,18 @@ void HEPTopTaggerV2::run() {
       double dummy = -99999;
 
       for (unsigned i = 0; i < small_fatjets.size(); i++) {
+	int hist_index = small_fatjets[i].cluster_hist_index();
+	map<int,HEPTopTaggerV2_fixed_R>::iterator prev = previous_htts.find(hist_index);
+	if (prev != previous_htts.end()) {
+	  HEPTopTaggerV2_fixed_R & htt = current_htts[hist_index];
+	  htt = prev->second;
+	  if (htt.t().perp() > dummy) {
+	    dummy = htt.t().perp();
+	    _HEPTopTaggerV2[R] = htt;
+	  }
+	  continue;
+	}
+
 	HEPTopTaggerV2_fixed_R htt(small_fatjets[i]);
 	htt.set_mass_drop_threshold(_mass_drop_threshold);
 	htt.set_max_subjet_mass(_max_subjet_mass);
@@ -533,15 +609,20 @@ void HEPTopTaggerV2::run() {
 	htt.set_pruning_zcut(_zcut);
 	htt.set_pruning_rcut_factor(_rcut_factor);
 	htt.set_debug(_debug);
+	htt.set_parallel_triplets(_parallel_triplets);
 	htt.set_qjets(_q_zcut, _q_dcut_fctr, _q_exp_min, _q_exp_max, _q_rigidity, _q_truncation_fctr);
 
 	htt.run();
+	current_htts[hist_index] = htt;
      
 	if (htt.t().perp() > dummy) {
 	  dummy = htt.t().perp();
 	  _HEPTopTaggerV2[R] = htt;
 	}
       } //End of loop over small_fatjets
+
+      previous_htts.swap(current_htts);
+      current_htts.clear();
     
       // Only check if we have not found Ropt yet
       if (_Ropt == 0 && R < maxR) {                 
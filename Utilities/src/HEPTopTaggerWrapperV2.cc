@@ -20,6 +20,7 @@
 #include "../interface/HEPTopTaggerWrapperV2.h"
 
 #include <fastjet/Error.hh>
+#include <fastjet/config.h>
 #include <fastjet/JetDefinition.hh>
 #include <fastjet/ClusterSequence.hh>
 #include "fastjet/PseudoJet.hh"
@@ -59,6 +60,22 @@ double R_min_expected_function(double x){
 
 
 
+//------------------------------------------------------------------------
+bool HEPTopTaggerV2::parallel_triplets_supported(){
+#ifdef FASTJET_HAVE_THREAD_SAFETY
+  return true;
+#else
+  return false;
+#endif
+}
+
+void HEPTopTaggerV2::set_parallel_triplets(bool parallel){
+  if (parallel && !parallel_triplets_supported())
+    throw Error("HEPTopTaggerV2: parallel triplet evaluation requires a FastJet build with thread safety");
+
+  parallelTriplets_ = parallel;
+}
+
 //------------------------------------------------------------------------
 // returns the tagged PseudoJet if successful, 0 otherwise
 //  - jet   the PseudoJet to tag
@@ -104,6 +121,8 @@ PseudoJet HEPTopTaggerV2::result(const PseudoJet & jet) const{
   // Set function to calculate R_min_expected
   tagger.set_optimalR_calc_fun(R_min_expected_function);
 
+  tagger.set_parallel_triplets(parallelTriplets_);
+
   
   double Qweight  = -1;
   double Qepsilon = -1;
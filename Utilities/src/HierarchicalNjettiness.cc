@@ -0,0 +1,37 @@
+/**
+ * \file HierarchicalNjettiness.cc
+ * \brief N-subjettiness for several N with a single seeding clustering
+ */
+#include "../interface/HierarchicalNjettiness.h"
+
+#include "fastjet/ClusterSequence.hh"
+#include "fastjet/contrib/AxesDefinition.hh"
+
+HierarchicalNjettiness::HierarchicalNjettiness(fastjet::contrib::MeasureDefinition const& measure, int maxN) :
+  maxN_(maxN),
+  seedDef_(fastjet::kt_algorithm, fastjet::JetDefinition::max_allowable_R, fastjet::E_scheme, fastjet::Best),
+  njettiness_(fastjet::contrib::OnePass_Manual_Axes(), measure)
+{
+}
+
+void HierarchicalNjettiness::getTaus(std::vector<fastjet::PseudoJet> const& inputs, double* taus) {
+  unsigned int nInputs = inputs.size();
+
+  // the kT history is only needed if there are more inputs than axes; otherwise tau is 0 and the axes are ignored
+  fastjet::ClusterSequence* seq = 0;
+  if (nInputs > 1)
+    seq = new fastjet::ClusterSequence(inputs, seedDef_);
+
+  for (int N=1; N<=maxN_; ++N) {
+    std::vector<fastjet::PseudoJet> seeds;
+    if (nInputs > unsigned(N))
+      seeds = seq->exclusive_jets_up_to(N);
+    else
+      seeds.resize(N, fastjet::PseudoJet(0., 0., 0., 0.));
+
+    njettiness_.setAxes(seeds);
+    taus[N-1] = njettiness_.getTau(N, inputs);
+  }
+
+  delete seq;
+}
@@ -0,0 +1,61 @@
+#include "../interface/KeySort.h"
+
+#include <algorithm>
+#include <numeric>
+
+using namespace panda;
+
+namespace {
+  // below this size the counting passes cost more than they save
+  unsigned const minRadixSize(64);
+}
+
+void
+panda::keySort(std::vector<uint64_t> const& _keys, std::vector<unsigned>& _order)
+{
+  unsigned n(_keys.size());
+
+  _order.resize(n);
+  std::iota(_order.begin(), _order.end(), 0);
+
+  if (n < 2)
+    return;
+
+  if (n < minRadixSize) {
+    std::stable_sort(_order.begin(), _order.end(), [&_keys](unsigned i1, unsigned i2) { return _keys[i1] < _keys[i2]; });
+    return;
+  }
+
+  // bits that differ between the keys
+  uint64_t varying(0);
+  for (uint64_t key : _keys)
+    varying |= key ^ _keys[0];
+
+  std::vector<unsigned> buffer(n);
+  unsigned* src(_order.data());
+  unsigned* dst(buffer.data());
+
+  for (unsigned shift(0); shift != 64; shift += 8) {
+    if (((varying >> shift) & 0xff) == 0)
+      continue;
+
+    unsigned offsets[256] = {};
+    for (unsigned i(0); i != n; ++i)
+      ++offsets[(_keys[src[i]] >> shift) & 0xff];
+
+    unsigned total(0);
+    for (unsigned& offset : offsets) {
+      unsigned count(offset);
+      offset = total;
+      total += count;
+    }
+
+    for (unsigned i(0); i != n; ++i)
+      dst[offsets[(_keys[src[i]] >> shift) & 0xff]++] = src[i];
+
+    std::swap(src, dst);
+  }
+
+  if (src != _order.data())
+    _order.assign(src, src + n);
+}
@@ -0,0 +1,46 @@
+/**
+ * \file PairwiseDeltaR2.cc
+ * \brief Batch computation of the dR^2 of all pairs in a set of particles
+ */
+#include "../interface/PairwiseDeltaR2.h"
+
+#include <cmath>
+
+constexpr double PairwiseDeltaR2::kPi;
+
+void PairwiseDeltaR2::fill(std::vector<fastjet::PseudoJet> const& particles) {
+  unsigned nP = particles.size();
+
+  pTs_.resize(nP);
+  etas_.resize(nP);
+  phis_.resize(nP);
+  for (unsigned iP=0; iP!=nP; ++iP) {
+    auto& particle = particles[iP];
+    pTs_[iP] = particle.perp();
+    etas_[iP] = particle.eta();
+    phis_[iP] = particle.phi();
+  }
+
+  dR2s_.resize(nP*(nP-1)/2);
+
+  double const* etas = etas_.data();
+  double const* phis = phis_.data();
+  for (unsigned iP=1; iP<nP; ++iP) {
+    double eta = etas[iP];
+    double phi = phis[iP];
+    double* row = dR2s_.data() + index(iP,0);
+    // inner loop is free of branches and aliasing for vectorization
+    for (unsigned jP=0; jP!=iP; ++jP)
+      row[jP] = compute(eta, phi, etas[jP], phis[jP]);
+  }
+}
+
+void PairwiseDeltaR2::fillPow(double const* halfBetas, unsigned nBetas, std::vector<double>& angles) const {
+  unsigned nPairs = dR2s_.size();
+  angles.resize(nPairs*nBetas);
+  for (unsigned p=0; p!=nPairs; ++p) {
+    double* out = angles.data() + p*nBetas;
+    for (unsigned iB=0; iB!=nBetas; ++iB)
+      out[iB] = std::pow(dR2s_[p], halfBetas[iB]);
+  }
+}